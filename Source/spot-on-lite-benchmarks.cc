@@ -0,0 +1,420 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+extern "C"
+{
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <string.h>
+}
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#endif
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVector>
+
+#include <iomanip>
+#include <iostream>
+
+#include "spot-on-lite-daemon-sha.h"
+#include "spot-on-lite-daemon-siphash.h"
+
+#ifdef SPOTON_LITE_DAEMON_CHILD_ECL_SUPPORTED
+#ifdef FALSE
+#undef FALSE
+#endif
+#ifdef SLOT
+#undef SLOT
+#endif
+#ifdef TRUE
+#undef TRUE
+#endif
+#ifdef slots
+#undef slots
+#endif
+#include <ecl/ecl.h>
+
+extern "C"
+{
+  extern void init_lib_SPOTON_LITE_DAEMON_SHA(cl_object);
+}
+#endif
+
+/*
+** Compares the digests of the congestion control table, the SHA-512
+** and HMAC-SHA-512 implementations, and the comparisons of digests on
+** messages of 64 bytes to 8 MiB. The Spot-On-Lite protocol carries
+** messages of a few kilobytes. Larger messages approach the maximum
+** accumulated bytes of a child. The first algorithm of a group is the
+** baseline of the group.
+**
+** Cycles are read from the time-stamp counter where there is one. It
+** counts at a constant reference rate.
+*/
+
+enum Algorithms
+{
+  COMPARE_CONSTANT_TIME = 0,
+  COMPARE_CRYPTO_MEMCMP,
+  COMPARE_MEMCMP,
+  ECL_SHA_512,
+  EVP_HMAC_SHA_512,
+  EVP_SHA_512,
+  HMAC_SHA_512,
+  HMAC_SHA_512_X8,
+  QT_SHA_512,
+  SHA3_384,
+  SHA3_384_BASE64,
+  SHA_512,
+  SIPHASH_2_4_128
+};
+
+struct benchmark_case
+{
+  const char *group;
+  const char *name;
+  int algorithm;
+  int operations; // Per iteration.
+  int size; // Zero if every size applies.
+};
+
+struct benchmark_context
+{
+  QByteArray data;
+  QByteArray hmac_key;
+  QByteArray other;
+  QByteArray siphash_key;
+  QVector<spot_on_lite_daemon_sha::hmac_key> keys;
+  spot_on_lite_daemon_sha sha;
+};
+
+static benchmark_case s_cases[] =
+  {{"congestion-control", "sha3-384+base64", SHA3_384_BASE64, 1, 0},
+   {"congestion-control", "sha3-384", SHA3_384, 1, 0},
+   {"congestion-control", "siphash-2-4-128", SIPHASH_2_4_128, 1, 0},
+   {"sha-512", "qt-sha-512", QT_SHA_512, 1, 0},
+   {"sha-512", "evp-sha-512", EVP_SHA_512, 1, 0},
+   {"sha-512", "sha-512", SHA_512, 1, 0},
+#ifdef SPOTON_LITE_DAEMON_CHILD_ECL_SUPPORTED
+   {"sha-512", "ecl-sha-512", ECL_SHA_512, 1, 0},
+#endif
+   {"hmac-sha-512", "evp-hmac-sha-512", EVP_HMAC_SHA_512, 1, 0},
+   {"hmac-sha-512", "hmac-sha-512", HMAC_SHA_512, 1, 0},
+   {"hmac-sha-512", "hmac-sha-512-x8", HMAC_SHA_512_X8, 8, 0},
+   {"compare", "memcmp", COMPARE_MEMCMP, 1, 64},
+   {"compare", "crypto-memcmp", COMPARE_CRYPTO_MEMCMP, 1, 64},
+   {"compare", "constant-time", COMPARE_CONSTANT_TIME, 1, 64}};
+
+static QByteArray sha3_384(const QByteArray &data)
+{
+#if QT_VERSION >= 0x050100
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha3_384);
+#else
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha384);
+#endif
+}
+
+static quint64 cycles(void)
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  return static_cast<quint64> (__rdtsc());
+#else
+  return 0;
+#endif
+}
+
+static char run(const int algorithm, benchmark_context &context)
+{
+  auto bytes = reinterpret_cast<const unsigned char *>
+    (context.data.constData());
+  auto size = static_cast<size_t> (context.data.length());
+  char digest[8 * spot_on_lite_daemon_sha::SHA_512_OUTPUT_LENGTH];
+  unsigned char evp_digest[EVP_MAX_MD_SIZE];
+  unsigned int length = 0;
+
+  switch(algorithm)
+    {
+    case COMPARE_CONSTANT_TIME:
+      {
+	return static_cast<char>
+	  (spot_on_lite_daemon_sha::
+	   digest_difference(context.data.constData(),
+			     context.other.constData()) == 0);
+      }
+    case COMPARE_CRYPTO_MEMCMP:
+      {
+	return static_cast<char>
+	  (CRYPTO_memcmp(context.data.constData(),
+			 context.other.constData(),
+			 static_cast<size_t> (context.other.length())) == 0);
+      }
+    case COMPARE_MEMCMP:
+      {
+	return static_cast<char>
+	  (memcmp(context.data.constData(),
+		  context.other.constData(),
+		  static_cast<size_t> (context.other.length())) == 0);
+      }
+    case ECL_SHA_512:
+      {
+	return context.sha.sha_512(context.data).at(0);
+      }
+    case EVP_HMAC_SHA_512:
+      {
+	HMAC(EVP_sha512(),
+	     context.hmac_key.constData(),
+	     context.hmac_key.length(),
+	     bytes,
+	     size,
+	     evp_digest,
+	     &length);
+	return static_cast<char> (evp_digest[0]);
+      }
+    case EVP_SHA_512:
+      {
+	EVP_Digest(bytes, size, evp_digest, &length, EVP_sha512(), nullptr);
+	return static_cast<char> (evp_digest[0]);
+      }
+    case HMAC_SHA_512:
+      {
+	context.sha.sha_512_hmac(context.data, context.keys.at(0), digest);
+	return digest[0];
+      }
+    case HMAC_SHA_512_X8:
+      {
+	context.sha.sha_512_hmac
+	  (context.data, context.keys.constData(), context.keys.size(), digest);
+	return digest[0];
+      }
+    case QT_SHA_512:
+      {
+	return QCryptographicHash::hash
+	  (context.data, QCryptographicHash::Sha512).at(0);
+      }
+    case SHA3_384:
+      {
+	return sha3_384(context.data).at(0);
+      }
+    case SHA3_384_BASE64:
+      {
+	return sha3_384(context.data).toBase64().at(0);
+      }
+    case SHA_512:
+      {
+	spot_on_lite_daemon_sha::sha_512_context c;
+
+	context.sha.sha_512_init(c);
+	context.sha.sha_512_update(c, context.data.constData(), size);
+	context.sha.sha_512_final(c, digest);
+	return digest[0];
+      }
+    default:
+      {
+	return spot_on_lite_daemon_siphash::siphash_2_4_128
+	  (context.siphash_key, context.data).at(0);
+      }
+    }
+}
+
+static qint64 benchmark(const benchmark_case &c,
+			benchmark_context &context,
+			double *cycles_per_operation,
+			double *ns_per_operation)
+{
+  /*
+  ** The iterations double until a run lasts 100 milliseconds. Returns
+  ** the number of operations of the final run.
+  */
+
+  qint64 iterations = 1;
+  volatile char sink = 0;
+
+  for(;;)
+    {
+      QElapsedTimer timer;
+      auto start = cycles();
+
+      timer.start();
+
+      for(qint64 i = 0; i < iterations; i++)
+	sink = static_cast<char> (sink ^ run(c.algorithm, context));
+
+      auto elapsed = timer.nsecsElapsed();
+      auto operations = iterations * c.operations;
+
+      if(elapsed >= 100000000 || iterations >= (static_cast<qint64> (1) << 40))
+	{
+	  *cycles_per_operation = static_cast<double> (cycles() - start) /
+	    static_cast<double> (operations);
+	  *ns_per_operation = static_cast<double> (elapsed) /
+	    static_cast<double> (operations);
+	  return operations;
+	}
+
+      iterations *= 2;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef SPOTON_LITE_DAEMON_CHILD_ECL_SUPPORTED
+  cl_boot(argc, argv);
+  ecl_init_module(nullptr, init_lib_SPOTON_LITE_DAEMON_SHA);
+  atexit(cl_shutdown);
+#endif
+
+  QCoreApplication application(argc, argv);
+  QList<int> sizes;
+  auto csv = application.arguments().contains("--csv");
+  benchmark_context context;
+
+  context.hmac_key = "Spot-On-Lite";
+  context.siphash_key.resize(spot_on_lite_daemon_siphash::KEY_SIZE);
+
+  for(int i = 0; i < 8; i++)
+    context.keys << context.sha.prepare_hmac_key
+      (context.hmac_key + QByteArray::number(i));
+
+  for(int i = 0; i < context.siphash_key.length(); i++)
+    context.siphash_key[i] = static_cast<char> (i);
+
+  sizes << 64
+	<< 256
+	<< 1024
+	<< 4096
+	<< 16384
+	<< 65536
+	<< 1048576
+	<< 8388608;
+
+  if(csv)
+    {
+      std::cerr << "sha-512 kernel: "
+		<< context.sha.sha_512_kernel().toStdString()
+		<< std::endl;
+      std::cout << "group,"
+		<< "algorithm,"
+		<< "bytes,"
+		<< "operations,"
+		<< "ns_per_op,"
+		<< "cycles_per_byte,"
+		<< "mib_per_second,"
+		<< "saving_percent"
+		<< std::endl;
+    }
+  else
+    std::cout << "SHA-512 kernel: "
+	      << context.sha.sha_512_kernel().toStdString()
+	      << std::endl
+	      << std::left
+	      << std::setw(10) << "bytes"
+	      << std::setw(18) << "algorithm"
+	      << std::setw(16) << "ns/op"
+	      << std::setw(14) << "cycles/byte"
+	      << std::setw(12) << "MiB/s"
+	      << "saving"
+	      << std::endl;
+
+  foreach(auto size, sizes)
+    {
+      QString group("");
+      double baseline = 0.0;
+
+      context.data.resize(size);
+
+      for(int i = 0; i < context.data.length(); i++)
+	context.data[i] = static_cast<char> (i * 31 + 7);
+
+      context.other = QByteArray
+	(context.data.constData(), qMin(size, 64)); // A deep copy.
+
+      for(const auto &c : s_cases)
+	{
+	  if(c.size != 0 && c.size != size)
+	    continue;
+
+	  double cycles_per_operation = 0.0;
+	  double ns = 0.0;
+	  auto operations = benchmark
+	    (c, context, &cycles_per_operation, &ns);
+	  auto cycles_per_byte = cycles_per_operation / size;
+	  auto mib = ns > 0.0 ? 1e9 * size / ns / (1024.0 * 1024.0) : 0.0;
+
+	  if(group != c.group)
+	    {
+	      baseline = ns;
+	      group = c.group;
+	    }
+
+	  auto saving = baseline > 0.0 ? 100.0 * (1.0 - ns / baseline) : 0.0;
+
+	  if(csv)
+	    {
+	      std::cout << c.group << ","
+			<< c.name << ","
+			<< size << ","
+			<< operations << ","
+			<< std::fixed << std::setprecision(1) << ns << ",";
+
+	      if(cycles_per_operation > 0.0)
+		std::cout << std::setprecision(3) << cycles_per_byte;
+
+	      std::cout << ","
+			<< std::setprecision(1) << mib << ","
+			<< std::setprecision(1) << saving
+			<< std::endl;
+	    }
+	  else
+	    {
+	      std::cout << std::left
+			<< std::setw(10) << size
+			<< std::setw(18) << c.name
+			<< std::setw(16) << std::fixed << std::setprecision(1)
+			<< ns
+			<< std::setw(14) << std::setprecision(3);
+
+	      if(cycles_per_operation > 0.0)
+		std::cout << cycles_per_byte;
+	      else
+		std::cout << "-";
+
+	      std::cout << std::setw(12) << std::setprecision(1) << mib
+			<< std::setprecision(1) << saving
+			<< "%"
+			<< std::endl;
+	    }
+	}
+    }
+
+  return 0;
+}
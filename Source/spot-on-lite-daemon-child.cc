@@ -43,6 +43,7 @@ extern "C"
 #include <unistd.h>
 }
 
+#include <QBitArray>
 #include <QCoreApplication>
 #include <QCryptographicHash>
 #include <QDateTime>
@@ -58,13 +59,11 @@ extern "C"
 #include <QUuid>
 #include <QtConcurrent>
 
+#include <algorithm>
 #include <limits>
 
-#include "spot-on-lite-common.h"
 #include "spot-on-lite-daemon-child.h"
-
-QReadWriteLock spot_on_lite_daemon_child::s_db_id_mutex;
-quint64 spot_on_lite_daemon_child::s_db_id = 0;
+#include "spot-on-lite-daemon-database.h"
 
 static QString socket_type_to_string
 (const QAbstractSocket::SocketType socket_type)
@@ -75,6 +74,73 @@ static QString socket_type_to_string
     return "UDP";
 }
 
+static QStringList certificates_schema(void)
+{
+  QStringList list;
+
+  list << "CREATE TABLE IF NOT EXISTS certificates ("
+	  "certificate BLOB NOT NULL, "
+	  "private_key BLOB NOT NULL, "
+	  "public_key BLOB NOT NULL, "
+	  "server_identity TEXT NOT NULL PRIMARY KEY)";
+  return list;
+}
+
+static QByteArray congestion_control_digest(const QByteArray &data)
+{
+#if QT_VERSION >= 0x050100
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha3_384);
+#else
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha384);
+#endif
+}
+
+static QStringList congestion_control_schema(void)
+{
+  QStringList list;
+
+  list << "CREATE TABLE IF NOT EXISTS congestion_control ("
+	  "date_time_inserted BIGINT NOT NULL, "
+	  "hash TEXT NOT NULL PRIMARY KEY)"
+       << "CREATE INDEX IF NOT EXISTS congestion_control_date_time_inserted "
+	  "ON congestion_control (date_time_inserted)"
+       << "PRAGMA journal_mode = OFF"
+       << "PRAGMA synchronous = OFF";
+  return list;
+}
+
+static QStringList remote_identities_schema(void)
+{
+  QStringList list;
+
+  list << "CREATE TABLE IF NOT EXISTS remote_identities ("
+	  "algorithm TEXT NOT NULL, "
+	  "date_time_inserted BIGINT NOT NULL, "
+	  "identity TEXT NOT NULL, "
+	  "pid BIGINT NOT NULL, "
+	  "PRIMARY KEY (identity, pid))";
+  return list;
+}
+
+static QStringList statistics_schema(void)
+{
+  QStringList list;
+
+  list << "CREATE TABLE IF NOT EXISTS statistics ("
+	  "arguments TEXT, "
+	  "bytes_accumulated TEXT, "
+	  "bytes_read TEXT, "
+	  "bytes_written TEXT, "
+	  "ip_information TEXT, "
+	  "memory TEXT, "
+	  "name TEXT, "
+	  "pid BIGINT NOT NULL PRIMARY KEY, "
+	  "type TEXT)"
+       << "PRAGMA journal_mode = OFF"
+       << "PRAGMA synchronous = OFF";
+  return list;
+}
+
 static int hash_algorithm_key_length(const QByteArray &a)
 {
   auto algorithm(a.toLower().trimmed());
@@ -89,14 +155,121 @@ static int hash_algorithm_key_length(const QByteArray &a)
 #if SPOTON_LITE_DAEMON_IDENTITIES_CONTAINER_MAXIMUM_SIZE > 0
 static int MAXIMUM_REMOTE_IDENTITIES =
   SPOTON_LITE_DAEMON_IDENTITIES_CONTAINER_MAXIMUM_SIZE;
+#else
+static int MAXIMUM_REMOTE_IDENTITIES = 65536;
 #endif
 #endif
 static auto FIVE_YEARS = 5L * 24L * 60L * 60L * 365L; // Five years.
 static int END_OF_MESSAGE_MARKER_WINDOW = 10000;
+static int IDENTITIES_RANKING_INTERVAL = 256; // Matched messages.
+static const int MAXIMUM_IDENTITIES_LIFETIME = 600; // Seconds.
+#ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
+static const int IDENTITIES_WHEEL_SIZE = 1024; // Seconds.
+
+/*
+** A bucket is expired once the lifetime has passed. The wheel must
+** therefore span more seconds than the longest lifetime. Otherwise,
+** the tail is held within the wheel and never passes the lifetime.
+*/
+
+static_assert(IDENTITIES_WHEEL_SIZE > MAXIMUM_IDENTITIES_LIFETIME,
+	      "The identities wheel is shorter than the maximum lifetime.");
+#endif
 static int MAXIMUM_TCP_WRITE_SIZE = 8192;
 static int MAXIMUM_UDP_WRITE_SIZE = 508;
 static int s_certificate_version = 3;
 
+#ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
+static quint64 monotonic_coarse_seconds(void)
+{
+  struct timespec ts = {};
+
+#ifdef CLOCK_MONOTONIC_COARSE
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+  return static_cast<quint64> (ts.tv_sec);
+}
+#endif
+
+struct spot_on_lite_daemon_child_identities_matching
+{
+  QAtomicInt *found; // Key index + 1.
+  QAtomicInt evaluated;
+  QAtomicInt next;
+  const QFuture<void> *future;
+  const QVector<QByteArray> *contents;
+  const QVector<QByteArray> *hashes;
+  const QVector<spot_on_lite_daemon_sha::hmac_key> *keys;
+  const spot_on_lite_daemon_sha *sha;
+  int chunk;
+  int chunks;
+  int tasks;
+};
+
+static bool hits_greater(const QPair<quint64, QByteArray> &a,
+			 const QPair<quint64, QByteArray> &b)
+{
+  return a.first > b.first;
+}
+
+static void match_identities_worker
+(spot_on_lite_daemon_child_identities_matching *matching)
+{
+  /*
+  ** A task pairs a message with a range of keys. Tasks are claimed in
+  ** order, so the tasks of a message are claimed together. The
+  ** remaining tasks of a matched message are skipped. The keys of a
+  ** range are evaluated in batches of LANES.
+  */
+
+  const int LANES = 8;
+  char digests[LANES * spot_on_lite_daemon_sha::SHA_512_OUTPUT_LENGTH];
+  int task = 0;
+
+  while((task = matching->next.fetchAndAddOrdered(1)) < matching->tasks)
+    {
+      auto message = task / matching->chunks;
+
+      if(matching->found[message].loadAcquire() ||
+	 matching->future->isCanceled())
+	continue;
+
+      auto first = (task % matching->chunks) * matching->chunk;
+      auto last = qMin(first + matching->chunk, matching->keys->size());
+      const auto &content(matching->contents->at(message));
+      const auto &hash(matching->hashes->at(message));
+
+      for(int i = first; i < last; i += LANES)
+	{
+	  if(matching->found[message].loadAcquire())
+	    break;
+
+	  auto count = qMin(LANES, last - i);
+
+	  matching->sha->sha_512_hmac
+	    (content, matching->keys->constData() + i, count, digests);
+	  matching->evaluated.fetchAndAddRelaxed(count);
+
+	  for(int j = 0; j < count; j++)
+	    if(spot_on_lite_daemon_child::
+	       memcmp(hash,
+		      digests + j * spot_on_lite_daemon_sha::
+		      SHA_512_OUTPUT_LENGTH,
+		      spot_on_lite_daemon_sha::SHA_512_OUTPUT_LENGTH))
+	      {
+		/*
+		** Found!
+		*/
+
+		matching->found[message].storeRelease(i + j + 1);
+		break;
+	      }
+	}
+    }
+}
+
 spot_on_lite_daemon_child::spot_on_lite_daemon_child
 (const QByteArray &initial_data,
  const QString &certificates_file_name,
@@ -128,9 +301,14 @@ spot_on_lite_daemon_child::spot_on_lite_daemon_child
   m_congestion_control_file_name = congestion_control_file_name;
   m_end_of_message_marker = end_of_message_marker.toUtf8();
   m_general_timer.start(5000);
+  m_identities_matching_threads = 1;
+  m_identity_hmacs = 0;
   m_identity_lifetime = static_cast<unsigned int>
-    (qBound(5, identities_lifetime, 600));
+    (qBound(5, identities_lifetime, MAXIMUM_IDENTITIES_LIFETIME));
+  m_identity_matches = 0;
+  m_identity_matches_since_ranking = 0;
   m_local_content_last_parsed = QDateTime::currentMSecsSinceEpoch();
+  m_local_content_received = 0;
   m_local_server_file_name = local_server_file_name;
   m_local_so_rcvbuf_so_sndbuf = qMax(4096, local_so_rcvbuf_so_sndbuf);
   m_log_file_name = log_file_name;
@@ -146,7 +324,13 @@ spot_on_lite_daemon_child::spot_on_lite_daemon_child
   m_protocol = protocol.toLower().trimmed() == "tcp" ?
     QAbstractSocket::TcpSocket : QAbstractSocket::UdpSocket;
   m_remote_content_last_parsed = QDateTime::currentMSecsSinceEpoch();
+  m_remote_content_received = 0;
   m_remote_identities_file_name = remote_identities_file_name;
+#ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
+  m_remote_identities.set_capacity(MAXIMUM_REMOTE_IDENTITIES);
+  m_remote_identities_wheel.resize(IDENTITIES_WHEEL_SIZE);
+  m_remote_identities_wheel_tail = monotonic_coarse_seconds();
+#endif
 
   if(m_protocol == QAbstractSocket::TcpSocket)
     m_remote_socket = new QSslSocket(this);
@@ -163,6 +347,23 @@ spot_on_lite_daemon_child::spot_on_lite_daemon_child
   m_statistics_file_name = QDir::tempPath() +
     QDir::separator() +
     "spot-on-lite-daemon-statistics.sqlite";
+  m_statistics_flush_interval = 500; // Milliseconds
+
+  if(!m_congestion_control_file_name.isEmpty())
+    m_congestion_control.attach
+      (spot_on_lite_daemon_congestion_control::
+       file_name(m_congestion_control_file_name));
+
+  if(!m_remote_identities_file_name.isEmpty())
+    m_identities.attach(spot_on_lite_daemon_identities::
+			file_name(m_remote_identities_file_name));
+
+  if(m_statistics.attach(false))
+    m_statistics.acquire(m_pid);
+
+  save_statistic(spot_on_lite_daemon_statistics::MAXIMUM_ACCUMULATED_BYTES,
+		 static_cast<quint64> (m_maximum_accumulated_bytes));
+
   save_statistic("pid", QString::number(QCoreApplication::applicationPid()));
 
   if(!(m_ssl_key_size == 2048 ||
@@ -218,7 +419,11 @@ spot_on_lite_daemon_child::spot_on_lite_daemon_child
       save_statistic("type", "server");
     }
 
+#ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
+  m_expired_identities_timer.start(1000); // A bucket of the wheel.
+#else
   m_expired_identities_timer.start(15000);
+#endif
   m_keep_alive_timer.start(m_silence);
   m_local_socket.setReadBufferSize(m_maximum_accumulated_bytes);
   connect(&m_attempt_local_connection_timer,
@@ -257,6 +462,10 @@ spot_on_lite_daemon_child::spot_on_lite_daemon_child
 	  SIGNAL(readyRead(void)),
 	  this,
 	  SLOT(slot_local_socket_ready_read(void)));
+  connect(&m_statistics_timer,
+	  SIGNAL(timeout(void)),
+	  this,
+	  SLOT(slot_statistics_timer_timeout(void)));
   connect(m_remote_socket,
 	  SIGNAL(disconnected(void)),
 	  this,
@@ -270,9 +479,9 @@ spot_on_lite_daemon_child::spot_on_lite_daemon_child
 	  this,
 	  SLOT(slot_local_socket_ready_read(void)));
   connect(this,
-	  SIGNAL(write_signal(const QByteArray &)),
+	  SIGNAL(write_signal(const QByteArray &, const qint64)),
 	  this,
-	  SLOT(slot_write_data(const QByteArray &)));
+	  SLOT(slot_write_data(const QByteArray &, const qint64)));
 
   if(!m_ssl_control_string.isEmpty() && m_ssl_key_size > 0)
     {
@@ -408,6 +617,7 @@ spot_on_lite_daemon_child::spot_on_lite_daemon_child
   save_statistic
     ("arguments", QCoreApplication::instance()->arguments().join(' '));
   save_statistic("name", QCoreApplication::instance()->arguments().value(0));
+  m_statistics_timer.start(m_statistics_flush_interval);
 }
 
 spot_on_lite_daemon_child::~spot_on_lite_daemon_child()
@@ -425,82 +635,162 @@ QHash<QByteArray, QString>spot_on_lite_daemon_child::remote_identities(bool *ok)
 
 #ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
   QReadLocker lock(&m_remote_identities_mutex);
-  QHashIterator<QByteArray, QDateTime> it(m_remote_identities);
 
-  while(it.hasNext())
+  foreach(const auto &identity, m_remote_identities.identities())
+    hash[identity] = "sha-512";
+#else
+  auto query = spot_on_lite_daemon_database::query
+    (m_remote_identities_file_name,
+     remote_identities_schema(),
+     "SELECT algorithm, identity FROM remote_identities "
+     "WHERE pid = ? ORDER BY date_time_inserted DESC");
+
+  if(query)
     {
-      it.next();
-      hash[it.key()] = "sha-512";
+      query->addBindValue(m_pid);
+
+      if(query->exec())
+	while(query->next())
+	  hash[QByteArray::fromBase64(query->value(1).toByteArray())] =
+	    query->value(0).toString();
+      else if(ok)
+	*ok = false;
+
+      query->finish();
     }
-#else
-  create_remote_identities_database();
+  else if(ok)
+    *ok = false;
+#endif
+  return hash;
+}
 
-  auto db_connection_id = db_id();
+std::shared_ptr<const spot_on_lite_daemon_child::identities_snapshot>
+spot_on_lite_daemon_child::remote_identities_snapshot(void)
+{
+  /*
+  ** The snapshot is rebuilt after the identities have changed and is
+  ** ranked again after some matches. Only the thread of
+  ** process_local_content() rebuilds snapshots and accesses
+  ** m_hmac_keys and m_identity_hits.
+  */
 
-  {
-    auto db = QSqlDatabase::addDatabase
-      ("QSQLITE", QString::number(db_connection_id));
+  auto generation = m_remote_identities_generation.loadAcquire();
+  auto snapshot(std::atomic_load(&m_remote_identities_snapshot));
+  auto current = snapshot && snapshot->generation == generation;
 
-    db.setDatabaseName(m_remote_identities_file_name);
+  if(current &&
+     m_identity_matches_since_ranking < IDENTITIES_RANKING_INTERVAL)
+    return snapshot;
 
-    if(db.open())
+  QHash<QByteArray, QString> identities;
+  auto ok = true;
+
+  if(current)
+    identities = snapshot->identities;
+  else
+    do
       {
-	QSqlQuery query(db);
-
-	query.setForwardOnly(true);
-	query.prepare
-	  ("SELECT algorithm, identity FROM remote_identities "
-	   "WHERE pid = ? ORDER BY date_time_inserted DESC");
-	query.addBindValue(m_pid);
-
-	if(query.exec())
-	  while(query.next())
-	    hash[QByteArray::fromBase64(query.value(1).toByteArray())] =
-	      query.value(0).toString();
-	else if(ok)
-	  *ok = false;
+	identities = remote_identities(&ok);
+
+	if(!ok)
+	  {
+	    struct timespec ts = {};
+
+	    ts.tv_nsec = 250000000; // 250 Milliseconds
+	    ts.tv_sec = 0;
+	    nanosleep(&ts, nullptr);
+	  }
+	else
+	  break;
       }
-    else if(ok)
-      *ok = false;
+    while(!m_process_local_content_future.isCanceled());
+
+  /*
+  ** Frequently matched identities are tried first. The hits decay by
+  ** half with every ranking so that the order follows recent traffic.
+  */
+
+  QVector<QPair<quint64, QByteArray> > ranks;
+  std::shared_ptr<identities_snapshot> rebuilt(new identities_snapshot);
+
+  ranks.reserve(identities.size());
+
+  for(auto it = identities.constBegin(); it != identities.constEnd(); ++it)
+    ranks << QPair<quint64, QByteArray> (m_identity_hits.value(it.key()),
+					 it.key());
+
+  std::stable_sort(ranks.begin(), ranks.end(), hits_greater);
+  rebuilt->generation = generation;
+  rebuilt->identities = identities;
+  rebuilt->keys.reserve(ranks.size());
+  rebuilt->order.reserve(ranks.size());
+
+  for(int i = 0; i < ranks.size(); i++)
+    {
+      const auto &identity(ranks.at(i).second);
+
+      if(!m_hmac_keys.contains(identity))
+	m_hmac_keys[identity] = m_sha_512.prepare_hmac_key(identity);
+
+      rebuilt->keys << m_hmac_keys.value(identity);
+      rebuilt->order << identity;
+    }
+
+  if(m_hmac_keys.size() > identities.size())
+    {
+      QMutableHashIterator<QByteArray, spot_on_lite_daemon_sha::hmac_key> it
+	(m_hmac_keys);
+
+      while(it.hasNext())
+	if(!identities.contains(it.next().key()))
+	  it.remove();
+    }
 
-    db.close();
+  {
+    QMutableHashIterator<QByteArray, quint64> it(m_identity_hits);
+
+    while(it.hasNext())
+      {
+	it.next();
+
+	if(it.value() <= 1 || !identities.contains(it.key()))
+	  it.remove();
+	else
+	  it.setValue(it.value() / 2);
+      }
   }
 
-  QSqlDatabase::removeDatabase(QString::number(db_connection_id));
-#endif
-  return hash;
+  m_identity_matches_since_ranking = 0;
+
+  if(ok)
+    std::atomic_store
+      (&m_remote_identities_snapshot,
+       std::shared_ptr<const identities_snapshot> (rebuilt));
+
+  return rebuilt;
 }
 
 QList<QByteArray> spot_on_lite_daemon_child::
 local_certificate_configuration(void)
 {
   QList<QByteArray> list;
-  auto db_connection_id = db_id();
-
-  {
-    auto db = QSqlDatabase::addDatabase
-      ("QSQLITE", QString::number(db_connection_id));
-
-    db.setDatabaseName(m_certificates_file_name);
-
-    if(db.open())
-      {
-	QSqlQuery query(db);
+  auto query = spot_on_lite_daemon_database::query
+    (m_certificates_file_name,
+     certificates_schema(),
+     "SELECT certificate, private_key FROM certificates "
+     "WHERE server_identity = ?");
 
-	query.setForwardOnly(true);
-	query.prepare("SELECT certificate, private_key FROM certificates "
-		      "WHERE server_identity = ?");
-	query.addBindValue(m_server_identity);
+  if(query)
+    {
+      query->addBindValue(m_server_identity);
 
-	if(query.exec() && query.next())
-	  list << QByteArray::fromBase64(query.value(0).toByteArray())
-	       << QByteArray::fromBase64(query.value(1).toByteArray());
-      }
+      if(query->exec() && query->next())
+	list << QByteArray::fromBase64(query->value(0).toByteArray())
+	     << QByteArray::fromBase64(query->value(1).toByteArray());
 
-    db.close();
-  }
+      query->finish();
+    }
 
-  QSqlDatabase::removeDatabase(QString::number(db_connection_id));
   return list;
 }
 
@@ -666,58 +956,156 @@ QList<QSslCipher> spot_on_lite_daemon_child::default_ssl_ciphers(void) const
 
 bool spot_on_lite_daemon_child::memcmp(const QByteArray &a, const QByteArray &b)
 {
-  auto length = qMax(a.length(), b.length());
-  quint64 rc = 0;
+  return memcmp(a, b.constData(), b.length());
+}
+
+bool spot_on_lite_daemon_child::memcmp
+(const QByteArray &a, const char *b, const int length)
+{
+  /*
+  ** The time depends on the lengths but not on the contents. Different
+  ** lengths are a difference.
+  */
+
+  auto bytes = a.constData();
+  auto l = qMin(a.length(), length);
+  auto rc = static_cast<quint64> (static_cast<uint> (a.length() ^ length));
+  int i = 0;
+
+  for(; l - i >= 64; i += 64)
+    rc |= spot_on_lite_daemon_sha::digest_difference(bytes + i, b + i);
 
-  for(int i = 0; i < length; i++)
-    rc |= (i < a.length() ? static_cast<quint64> (a.at(i)) : 0ULL) ^
-      (i < b.length() ? static_cast<quint64> (b.at(i)) : 0ULL);
+  for(; i < l; i++)
+    rc |= static_cast<uchar> (bytes[i] ^ b[i]);
 
   return rc == 0;
 }
 
-bool spot_on_lite_daemon_child::record_congestion
-(const QByteArray &data)
+QVector<int> spot_on_lite_daemon_child::match_identities
+(const QVector<QByteArray> &contents,
+ const QVector<QByteArray> &hashes,
+ const QVector<spot_on_lite_daemon_sha::hmac_key> &keys)
 {
-  auto added = false;
-  auto db_connection_id = db_id();
+  /*
+  ** Returns the index of the key of each message, or -1.
+  */
 
-  {
-    auto db = QSqlDatabase::addDatabase
-      ("QSQLITE", QString::number(db_connection_id));
+  QVector<int> indices(contents.size(), -1);
 
-    db.setDatabaseName(m_congestion_control_file_name);
+  if(contents.isEmpty() || keys.isEmpty())
+    return indices;
 
-    if(db.open())
-      {
-	QSqlQuery query(db);
-
-	query.exec("CREATE TABLE IF NOT EXISTS congestion_control ("
-		   "date_time_inserted BIGINT NOT NULL, "
-		   "hash TEXT NOT NULL PRIMARY KEY)");
-	query.exec("PRAGMA journal_mode = OFF");
-	query.exec("PRAGMA synchronous = OFF");
-	query.prepare("INSERT INTO congestion_control "
-		      "(date_time_inserted, hash) "
-		      "VALUES (?, ?)");
-	query.addBindValue(QDateTime::currentDateTime().toTime_t());
-#if QT_VERSION >= 0x050100
-	query.addBindValue
-	  (QCryptographicHash::hash(data, QCryptographicHash::Sha3_384).
-	   toBase64());
-#else
-	query.addBindValue
-	  (QCryptographicHash::hash(data, QCryptographicHash::Sha384).
-	   toBase64());
+  QVector<QAtomicInt> found(contents.size());
+  spot_on_lite_daemon_child_identities_matching matching;
+
+  matching.chunk = qMax
+    (16, keys.size() / (4 * m_identities_matching_threads) + 1);
+  matching.chunks = (keys.size() + matching.chunk - 1) / matching.chunk;
+  matching.contents = &contents;
+  matching.found = found.data();
+  matching.future = &m_process_local_content_future;
+  matching.hashes = &hashes;
+  matching.keys = &keys;
+  matching.sha = &m_sha_512;
+  matching.tasks = contents.size() * matching.chunks;
+
+  QVector<QFuture<void> > futures;
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 4, 0))
+  for(int i = 1; i < qMin(m_identities_matching_threads, matching.tasks); i++)
+    futures << QtConcurrent::run
+      (&m_identities_pool, match_identities_worker, &matching);
 #endif
-	added = query.exec();
-      }
 
-    db.close();
-  }
+  match_identities_worker(&matching);
+
+  for(int i = 0; i < futures.size(); i++)
+    futures[i].waitForFinished();
+
+  for(int i = 0; i < contents.size(); i++)
+    indices[i] = found.at(i).loadAcquire() - 1;
+
+  m_identity_hmacs += static_cast<quint64> (matching.evaluated.loadAcquire());
+  return indices;
+}
+
+QBitArray spot_on_lite_daemon_child::record_congestion
+(const QVector<QByteArray> &messages)
+{
+  /*
+  ** Set bits identify new messages. The messages of a burst are
+  ** recorded in a single pass or in a single transaction.
+  */
+
+  QBitArray bits(messages.size());
+
+  if(messages.isEmpty())
+    return bits;
+
+  if(m_congestion_control.hub_deduplication())
+    {
+      /*
+      ** The daemon examines the messages which it relays.
+      */
+
+      bits.fill(true);
+      return bits;
+    }
+
+  auto start = spot_on_lite_daemon_histogram::now();
+
+  if(m_congestion_control.is_attached())
+    for(int i = 0; i < messages.size(); i++)
+      bits.setBit
+	(i,
+	 m_congestion_control.
+	 insert(m_congestion_control.digest(messages.at(i))));
+  else
+    {
+      /*
+      ** The daemon could not create the shared table.
+      */
+
+      auto query = spot_on_lite_daemon_database::query
+	(m_congestion_control_file_name,
+	 congestion_control_schema(),
+	 "INSERT INTO congestion_control (date_time_inserted, hash) "
+	 "VALUES (?, ?)");
+
+      if(query)
+	{
+	  auto date_time_inserted = QDateTime::currentDateTime().toTime_t();
+	  auto db(spot_on_lite_daemon_database::
+		  database(m_congestion_control_file_name,
+			   congestion_control_schema()));
+
+	  db.transaction();
+
+	  for(int i = 0; i < messages.size(); i++)
+	    {
+	      query->addBindValue(date_time_inserted);
+	      query->addBindValue
+		(congestion_control_digest(messages.at(i)).toBase64());
+	      bits.setBit(i, query->exec());
+	    }
 
-  QSqlDatabase::removeDatabase(QString::number(db_connection_id));
-  return added;
+	  query->finish();
+	  db.commit();
+	}
+    }
+
+  auto elapsed = (spot_on_lite_daemon_histogram::now() - start) /
+    messages.size();
+
+  for(int i = 0; i < messages.size(); i++)
+    m_latencies[REMOTE_CONGESTION].record(elapsed);
+
+  return bits;
+}
+
+bool spot_on_lite_daemon_child::record_congestion(const QByteArray &data)
+{
+  return record_congestion(QVector<QByteArray> () << data).testBit(0);
 }
 
 int spot_on_lite_daemon_child::bytes_accumulated(void) const
@@ -767,41 +1155,6 @@ int spot_on_lite_daemon_child::bytes_in_send_queue(void) const
   return count;
 }
 
-quint64 spot_on_lite_daemon_child::db_id(void)
-{
-  QWriteLocker lock(&s_db_id_mutex);
-
-  s_db_id += 1;
-  return s_db_id;
-}
-
-void spot_on_lite_daemon_child::create_remote_identities_database(void)
-{
-  auto db_connection_id = db_id();
-
-  {
-    auto db = QSqlDatabase::addDatabase
-      ("QSQLITE", QString::number(db_connection_id));
-
-    db.setDatabaseName(m_remote_identities_file_name);
-
-    if(db.open())
-      {
-	QSqlQuery query(db);
-
-	query.exec("CREATE TABLE IF NOT EXISTS remote_identities ("
-		   "algorithm TEXT NOT NULL, "
-		   "date_time_inserted BIGINT NOT NULL, "
-		   "identity TEXT NOT NULL PRIMARY KEY, "
-		   "pid BIGINT NOT NULL)");
-      }
-
-    db.close();
-  }
-
-  QSqlDatabase::removeDatabase(QString::number(db_connection_id));
-}
-
 void spot_on_lite_daemon_child::data_received
 (const QByteArray &data,
  const QHostAddress &peer_address,
@@ -1291,7 +1644,8 @@ void spot_on_lite_daemon_child::prepare_local_socket(void)
 
   m_local_socket.abort();
   m_local_socket.connectToServer(m_local_server_file_name);
-  save_statistic("bytes_accumulated", QString::number(bytes_accumulated()));
+  save_statistic(spot_on_lite_daemon_statistics::BYTES_ACCUMULATED,
+		 static_cast<quint64> (bytes_accumulated()));
 }
 
 void spot_on_lite_daemon_child::prepare_ssl_tls_configuration
@@ -1360,9 +1714,35 @@ void spot_on_lite_daemon_child::process_configuration_file(void)
   QSettings settings(m_configuration_file_name, QSettings::IniFormat);
 
   foreach(const auto &key, settings.allKeys())
-    if(key == "type_capabilities" ||
-       key == "type_identity" ||
-       key == "type_spot_on_lite_client")
+    if(key == "identities_matching_threads")
+      {
+	auto ok = true;
+	auto identities_matching_threads = settings.value(key).toInt(&ok);
+
+	if(ok)
+	  {
+	    /*
+	    ** This thread participates in the matching.
+	    */
+
+	    m_identities_matching_threads = qBound
+	      (1, identities_matching_threads, 256);
+	    m_identities_pool.setMaxThreadCount
+	      (qMax(1, m_identities_matching_threads - 1));
+	  }
+      }
+    else if(key == "statistics_flush_interval")
+      {
+	auto ok = true;
+	auto statistics_flush_interval = settings.value(key).toInt(&ok);
+
+	if(ok)
+	  m_statistics_flush_interval = qBound
+	    (50, statistics_flush_interval, 60000);
+      }
+    else if(key == "type_capabilities" ||
+	    key == "type_identity" ||
+	    key == "type_spot_on_lite_client")
       m_message_types[key] = settings.value(key).toByteArray();
 }
 
@@ -1380,43 +1760,34 @@ void spot_on_lite_daemon_child::process_local_content(void)
 
     if(m_end_of_message_marker.isEmpty())
       {
-	emit write_signal(m_local_content);
+	emit write_signal(m_local_content, m_local_content_received);
 	m_local_content.clear();
 	m_local_content_last_parsed = QDateTime::currentMSecsSinceEpoch();
 	lock.unlock();
-	save_statistic
-	  ("bytes_accumulated", QString::number(bytes_accumulated()));
+	save_statistic(spot_on_lite_daemon_statistics::BYTES_ACCUMULATED,
+		       static_cast<quint64> (bytes_accumulated()));
 	return;
       }
   }
 
-  QHash<QByteArray, QString> identities;
-
-  do
-    {
-      auto ok = true;
-
-      identities = remote_identities(&ok);
-
-      if(!ok)
-	{
-	  struct timespec ts = {};
-
-	  ts.tv_nsec = 250000000; // 250 Milliseconds
-	  ts.tv_sec = 0;
-	  nanosleep(&ts, nullptr);
-	}
-      else
-	break;
-    }
-  while(!m_process_local_content_future.isCanceled());
+  auto snapshot(remote_identities_snapshot());
+  const auto &identities(snapshot->identities);
+  const auto &keys(snapshot->keys);
 
+  QBitArray matched;
+  QVector<QByteArray> contents;
+  QVector<QByteArray> hashes;
   QVector<QByteArray> vector;
+  QVector<int> positions;
   auto type_identity(m_message_types.value("type_identity"));
   int index = 0;
+  qint64 received = 0;
 
   {
     QWriteLocker lock(&m_local_content_mutex);
+    auto start = spot_on_lite_daemon_histogram::now();
+
+    received = m_local_content_received;
 
     while((index = m_local_content.indexOf(m_end_of_message_marker)) >= 0)
       {
@@ -1430,16 +1801,28 @@ void spot_on_lite_daemon_child::process_local_content(void)
 
 	vector.append(bytes);
 	m_local_content.remove(0, bytes.length());
+	m_latencies[LOCAL_PARSE].record_since(start);
+	start = spot_on_lite_daemon_histogram::now();
       }
   }
 
-  save_statistic("bytes_accumulated", QString::number(bytes_accumulated()));
+  save_statistic(spot_on_lite_daemon_statistics::BYTES_ACCUMULATED,
+		 static_cast<quint64> (bytes_accumulated()));
 
   if(m_process_local_content_future.isCanceled() || vector.isEmpty())
     goto done_label;
 
-  for(const auto &bytes : vector)
+  /*
+  ** Messages are emitted in their original order. Messages which carry
+  ** a destination are matched against the identities together.
+  */
+
+  matched.resize(vector.size());
+
+  for(int i = 0; i < vector.size(); i++)
     {
+      const auto &bytes(vector.at(i));
+
       if(bytes.contains("type=" + type_identity + "&content="))
 	{
 	  if(m_spot_on_lite)
@@ -1449,7 +1832,7 @@ void spot_on_lite_daemon_child::process_local_content(void)
 	    ** share the identity with it.
 	    */
 
-	    emit write_signal(bytes);
+	    matched.setBit(i);
 
 	  continue;
 	}
@@ -1461,7 +1844,7 @@ void spot_on_lite_daemon_child::process_local_content(void)
 	  ** process.
 	  */
 
-	  emit write_signal(bytes);
+	  matched.setBit(i);
 	  continue;
 	}
 
@@ -1490,27 +1873,45 @@ void spot_on_lite_daemon_child::process_local_content(void)
 	      data = data.mid(0, data.length() - hash.length());
 	    }
 
-	  QHashIterator<QByteArray, QString> it(identities);
+	  contents << data;
+	  hashes << hash;
+	  positions << i;
+	}
+      else
+	matched.setBit(i);
+    }
 
-	  while(it.hasNext() && !m_process_local_content_future.isCanceled())
-	    {
-	      it.next();
+  if(!positions.isEmpty())
+    {
+      auto start = spot_on_lite_daemon_histogram::now();
+      auto indices(match_identities(contents, hashes, keys));
+      auto elapsed = (spot_on_lite_daemon_histogram::now() - start) /
+	positions.size();
 
-	      if(memcmp(hash, m_sha_512.sha_512_hmac(data, it.key())))
-		{
-		  /*
-		  ** Found!
-		  */
+      for(int i = 0; i < positions.size(); i++)
+	{
+	  m_latencies[LOCAL_IDENTITY].record(elapsed);
 
-		  emit write_signal(bytes);
-		  break;
-		}
+	  if(indices.at(i) >= 0)
+	    {
+	      m_identity_hits[snapshot->order.at(indices.at(i))] += 1;
+	      m_identity_matches += 1;
+	      m_identity_matches_since_ranking += 1;
+	      m_identity_ranks.record(indices.at(i) + 1);
+	      matched.setBit(positions.at(i));
 	    }
 	}
-      else
-	emit write_signal(bytes);
+
+      save_statistic(spot_on_lite_daemon_statistics::IDENTITY_HMACS,
+		     m_identity_hmacs);
+      save_statistic(spot_on_lite_daemon_statistics::IDENTITY_MATCHES,
+		     m_identity_matches);
     }
 
+  for(int i = 0; i < vector.size(); i++)
+    if(matched.testBit(i))
+      emit write_signal(vector.at(i), received);
+
  done_label:
 
   if(m_process_local_content_future.isCanceled())
@@ -1518,12 +1919,13 @@ void spot_on_lite_daemon_child::process_local_content(void)
       {
 	QWriteLocker lock(&m_local_content_mutex);
 
+	record_dropped_bytes(m_local_content.length());
 	m_local_content.clear();
 	m_local_content_last_parsed = QDateTime::currentMSecsSinceEpoch();
       }
 
-      save_statistic
-	("bytes_accumulated", QString::number(bytes_accumulated()));
+      save_statistic(spot_on_lite_daemon_statistics::BYTES_ACCUMULATED,
+		     static_cast<quint64> (bytes_accumulated()));
     }
   else
     {
@@ -1542,6 +1944,8 @@ void spot_on_lite_daemon_child::process_read_data(const QByteArray &data)
 
   if(data.isEmpty())
     return;
+  else
+    m_remote_content_received = spot_on_lite_daemon_histogram::now();
 
   if(m_client_role || m_end_of_message_marker.isEmpty())
     {
@@ -1555,16 +1959,25 @@ void spot_on_lite_daemon_child::process_read_data(const QByteArray &data)
 
 	  if(maximum > 0)
 	    {
+	      auto start = spot_on_lite_daemon_histogram::now();
 	      qint64 rc = m_local_socket.write(data.mid(0, maximum));
 
+	      m_latencies[REMOTE_TOTAL].record_since(m_remote_content_received);
+	      m_latencies[REMOTE_WRITE].record_since(start);
+
 	      if(rc > 0)
 		{
 		  m_bytes_written += static_cast<quint64> (rc);
-		  save_statistic
-		    ("bytes_written",
-		     QString::number(m_bytes_written.fetchAndAddOrdered(0ULL)));
+		  save_statistic(spot_on_lite_daemon_statistics::BYTES_WRITTEN,
+				 m_bytes_written.fetchAndAddOrdered(0ULL));
 		}
+
+	      record_dropped_bytes(data.length() - qMax(0LL, rc));
 	    }
+	  else
+	    record_dropped_bytes(data.length());
+
+	  record_queues();
 	}
 
       if(m_end_of_message_marker.isEmpty())
@@ -1575,15 +1988,20 @@ void spot_on_lite_daemon_child::process_read_data(const QByteArray &data)
 
   if(m_remote_content.length() >= m_maximum_accumulated_bytes)
     {
+      record_dropped_bytes(m_remote_content.length());
       m_remote_content.clear();
       m_remote_content_last_parsed = QDateTime::currentMSecsSinceEpoch();
     }
 
+  auto length = m_remote_content.length();
+
   m_remote_content.
     append(data.mid(0, qAbs(m_maximum_accumulated_bytes -
 			    m_remote_content.length())));
+  record_dropped_bytes(data.length() - (m_remote_content.length() - length));
   process_remote_content();
-  save_statistic("bytes_accumulated", QString::number(bytes_accumulated()));
+  save_statistic(spot_on_lite_daemon_statistics::BYTES_ACCUMULATED,
+		 static_cast<quint64> (bytes_accumulated()));
 }
 
 void spot_on_lite_daemon_child::process_remote_content(void)
@@ -1593,6 +2011,7 @@ void spot_on_lite_daemon_child::process_remote_content(void)
     return;
 
   QByteArray data;
+  QVector<QByteArray> messages;
   auto type_capabilities
     (m_message_types.value("type_capabilities"));
   auto type_identity(m_message_types.value("type_identity"));
@@ -1600,7 +2019,9 @@ void spot_on_lite_daemon_child::process_remote_content(void)
     (m_message_types.value("type_spot_on_lite_client"));
   int index = 0;
 
-  while((index = m_remote_content.indexOf(m_end_of_message_marker)) >= 0)
+  for(auto start = spot_on_lite_daemon_histogram::now();
+      (index = m_remote_content.indexOf(m_end_of_message_marker)) >= 0;
+      start = spot_on_lite_daemon_histogram::now())
     {
       data = m_remote_content.mid(0, index + m_end_of_message_marker.length());
       m_remote_content.remove(0, data.length());
@@ -1623,28 +2044,56 @@ void spot_on_lite_daemon_child::process_remote_content(void)
 	}
       else if(data.contains("type=" + type_spot_on_lite_client + "&content="))
 	{
-	  m_spot_on_lite = true;
+	  if(!m_spot_on_lite)
+	    {
+	      m_spot_on_lite = true;
+	      send_registered_identities();
+	    }
+
 	  continue;
 	}
 
-      if(record_congestion(data))
+      m_latencies[REMOTE_PARSE].record_since(start);
+      messages << data;
+    }
+
+  /*
+  ** The messages of a burst are examined together.
+  */
+
+  auto bits(record_congestion(messages));
+
+  for(int i = 0; i < messages.size(); i++)
+    {
+      if(!bits.testBit(i))
+	continue;
+
+      const auto &message(messages.at(i));
+      auto maximum = m_local_so_rcvbuf_so_sndbuf -
+	static_cast<int> (m_local_socket.bytesToWrite());
+
+      if(maximum > 0)
 	{
-	  auto maximum = m_local_so_rcvbuf_so_sndbuf -
-	    static_cast<int> (m_local_socket.bytesToWrite());
+	  auto start = spot_on_lite_daemon_histogram::now();
+	  auto rc = m_local_socket.write(message.mid(0, maximum));
 
-	  if(maximum > 0)
-	    {
-	      auto rc = m_local_socket.write(data.mid(0, maximum));
+	  m_latencies[REMOTE_TOTAL].record_since(m_remote_content_received);
+	  m_latencies[REMOTE_WRITE].record_since(start);
 
-	      if(rc > 0)
-		m_bytes_written += static_cast<quint64> (rc);
-	    }
+	  if(rc > 0)
+	    m_bytes_written += static_cast<quint64> (rc);
+
+	  record_dropped_bytes(message.length() - qMax(0LL, rc));
 	}
+      else
+	record_dropped_bytes(message.length());
     }
 
-  save_statistic("bytes_accumulated", QString::number(bytes_accumulated()));
-  save_statistic("bytes_written",
-		 QString::number(m_bytes_written.fetchAndAddOrdered(0ULL)));
+  record_queues();
+  save_statistic(spot_on_lite_daemon_statistics::BYTES_ACCUMULATED,
+		 static_cast<quint64> (bytes_accumulated()));
+  save_statistic(spot_on_lite_daemon_statistics::BYTES_WRITTEN,
+		 m_bytes_written.fetchAndAddOrdered(0ULL));
 }
 
 void spot_on_lite_daemon_child::purge_containers(void)
@@ -1659,7 +2108,8 @@ void spot_on_lite_daemon_child::purge_containers(void)
   m_remote_content.clear();
   m_remote_content_last_parsed = QDateTime::currentMSecsSinceEpoch();
   purge_remote_identities();
-  save_statistic("bytes_accumulated", QString::number(bytes_accumulated()));
+  save_statistic(spot_on_lite_daemon_statistics::BYTES_ACCUMULATED,
+		 static_cast<quint64> (bytes_accumulated()));
 }
 
 void spot_on_lite_daemon_child::purge_remote_identities(void)
@@ -1668,54 +2118,72 @@ void spot_on_lite_daemon_child::purge_remote_identities(void)
   QWriteLocker lock(&m_remote_identities_mutex);
 
   m_remote_identities.clear();
-#else
-  auto db_connection_id = db_id();
 
-  {
-    auto db = QSqlDatabase::addDatabase
-      ("QSQLITE", QString::number(db_connection_id));
-
-    db.setDatabaseName(m_remote_identities_file_name);
-
-    if(db.open())
-      {
-	QSqlQuery query(db);
-
-	query.prepare("DELETE FROM remote_identities WHERE pid = ?");
-	query.addBindValue(m_pid);
-	query.exec();
-      }
-
-    db.close();
-  }
+  for(int i = 0; i < m_remote_identities_wheel.size(); i++)
+    m_remote_identities_wheel[i].clear();
+#else
+  auto query = spot_on_lite_daemon_database::query
+    (m_remote_identities_file_name,
+     remote_identities_schema(),
+     "DELETE FROM remote_identities WHERE pid = ?");
 
-  QSqlDatabase::removeDatabase(QString::number(db_connection_id));
+  if(query)
+    {
+      query->addBindValue(m_pid);
+      query->exec();
+    }
 #endif
+  m_remote_identities_generation.fetchAndAddOrdered(1);
 }
 
 void spot_on_lite_daemon_child::purge_statistics(void)
 {
-  auto db_connection_id = db_id();
+  m_statistics_future.cancel();
+  m_statistics_timer.stop();
+  m_statistics_future.waitForFinished();
+
+  /*
+  ** Write the final values, such as the bytes which were read and
+  ** written before the disconnection, before the slot is released.
+  */
+
+  save_statistics();
+  m_statistics.release();
 
   {
-    auto db = QSqlDatabase::addDatabase
-      ("QSQLITE", QString::number(db_connection_id));
+    QWriteLocker lock(&m_dirty_statistics_mutex);
 
-    db.setDatabaseName(m_statistics_file_name);
+    m_dirty_statistics.clear();
+  }
 
-    if(db.open())
-      {
-	QSqlQuery query(db);
+  auto query = spot_on_lite_daemon_database::query
+    (m_statistics_file_name,
+     statistics_schema(),
+     "DELETE FROM statistics WHERE pid = ?");
 
-	query.prepare("DELETE FROM statistics WHERE pid = ?");
-	query.addBindValue(m_pid);
-	query.exec();
-      }
+  if(query)
+    {
+      query->addBindValue(m_pid);
+      query->exec();
+    }
+}
 
-    db.close();
-  }
+void spot_on_lite_daemon_child::record_dropped_bytes(const qint64 bytes)
+{
+  if(bytes <= 0)
+    return;
+
+  m_bytes_dropped += static_cast<quint64> (bytes);
+  save_statistic(spot_on_lite_daemon_statistics::BYTES_DROPPED,
+		 m_bytes_dropped.fetchAndAddOrdered(0ULL));
+}
 
-  QSqlDatabase::removeDatabase(QString::number(db_connection_id));
+void spot_on_lite_daemon_child::record_queues(void)
+{
+  save_statistic(spot_on_lite_daemon_statistics::LOCAL_QUEUE,
+		 static_cast<quint64> (qMax(0LL, m_local_socket.bytesToWrite())));
+  save_statistic(spot_on_lite_daemon_statistics::REMOTE_QUEUE,
+		 static_cast<quint64> (qMax(0, bytes_in_send_queue())));
 }
 
 void spot_on_lite_daemon_child::record_certificate
@@ -1726,38 +2194,21 @@ void spot_on_lite_daemon_child::record_certificate
   if(m_client_role)
     return;
 
-  auto db_connection_id = db_id();
+  auto query = spot_on_lite_daemon_database::query
+    (m_certificates_file_name,
+     certificates_schema(),
+     "INSERT INTO certificates "
+     "(certificate, private_key, public_key, server_identity) "
+     "VALUES (?, ?, ?, ?)");
 
-  {
-    auto db = QSqlDatabase::addDatabase
-      ("QSQLITE", QString::number(db_connection_id));
-
-    db.setDatabaseName(m_certificates_file_name);
-
-    if(db.open())
-      {
-	QSqlQuery query(db);
-
-	query.exec("CREATE TABLE IF NOT EXISTS certificates ("
-		   "certificate BLOB NOT NULL, "
-		   "private_key BLOB NOT NULL, "
-		   "public_key BLOB NOT NULL, "
-		   "server_identity TEXT NOT NULL PRIMARY KEY)");
-	query.prepare
-	  ("INSERT INTO certificates "
-	   "(certificate, private_key, public_key, server_identity) "
-	   "VALUES (?, ?, ?, ?)");
-	query.addBindValue(certificate.toBase64());
-	query.addBindValue(private_key.toBase64());
-	query.addBindValue(public_key.toBase64());
-	query.addBindValue(m_server_identity);
-	query.exec();
-      }
-
-    db.close();
-  }
-
-  QSqlDatabase::removeDatabase(QString::number(db_connection_id));
+  if(query)
+    {
+      query->addBindValue(certificate.toBase64());
+      query->addBindValue(private_key.toBase64());
+      query->addBindValue(public_key.toBase64());
+      query->addBindValue(m_server_identity);
+      query->exec();
+    }
 }
 
 void spot_on_lite_daemon_child::record_remote_identity
@@ -1789,97 +2240,358 @@ void spot_on_lite_daemon_child::record_remote_identity
   if(hash_algorithm_key_length(algorithm) == identity.length())
     {
 #ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
-      QWriteLocker lock(&m_remote_identities_mutex);
-
-      if(!m_remote_identities.contains(identity))
-	{
-	  if(MAXIMUM_REMOTE_IDENTITIES > m_remote_identities.size())
-	    m_remote_identities[identity] = QDateTime::currentDateTime();
-	}
-      else
-	m_remote_identities[identity] = QDateTime::currentDateTime();
-#else
-      create_remote_identities_database();
+      /*
+      ** The identity is appended to the bucket of the current second
+      ** unless it was already recorded during the second. A full
+      ** container evicts the least recently seen identity.
+      */
 
-      auto db_connection_id = db_id();
+      quint64 evictions = 0;
 
       {
-	auto db = QSqlDatabase::addDatabase
-	  ("QSQLITE", QString::number(db_connection_id));
+	QWriteLocker lock(&m_remote_identities_mutex);
+	auto now = monotonic_coarse_seconds();
 
-	db.setDatabaseName(m_remote_identities_file_name);
+	evictions = m_remote_identities.evictions();
 
-	if(db.open())
-	  {
-	    QSqlQuery query(db);
-
-	    query.prepare("INSERT OR REPLACE INTO remote_identities "
-			  "(algorithm, date_time_inserted, identity, pid) "
-			  "VALUES (?, ?, ?, ?)");
-	    query.addBindValue(algorithm);
-	    query.addBindValue(QDateTime::currentDateTime().toTime_t());
-	    query.addBindValue(identity.toBase64());
-	    query.addBindValue(m_pid);
-	    query.exec();
-	  }
+	if(m_remote_identities.time(identity) != now)
+	  m_remote_identities_wheel
+	    [static_cast<int> (now % IDENTITIES_WHEEL_SIZE)] << identity;
+
+	if(m_remote_identities.insert(identity, now))
+	  m_remote_identities_generation.fetchAndAddOrdered(1);
 
-	db.close();
+	if(evictions == m_remote_identities.evictions())
+	  evictions = 0;
+	else
+	  evictions = m_remote_identities.evictions();
       }
 
-      QSqlDatabase::removeDatabase(QString::number(db_connection_id));
+      if(evictions > 0)
+	save_statistic(spot_on_lite_daemon_statistics::IDENTITY_EVICTIONS,
+		       evictions);
+#else
+      auto query = spot_on_lite_daemon_database::query
+	(m_remote_identities_file_name,
+	 remote_identities_schema(),
+	 "INSERT OR REPLACE INTO remote_identities "
+	 "(algorithm, date_time_inserted, identity, pid) "
+	 "VALUES (?, ?, ?, ?)");
+
+      if(query)
+	{
+	  query->addBindValue(algorithm);
+	  query->addBindValue(QDateTime::currentDateTime().toTime_t());
+	  query->addBindValue(identity.toBase64());
+	  query->addBindValue(m_pid);
+
+	  /*
+	  ** Every child owns its rows, so replacing a row never removes
+	  ** an identity from the snapshot of another child. Refreshing
+	  ** an identity of the current snapshot does not change the set.
+	  */
+
+	  if(query->exec())
+	    {
+	      auto snapshot(std::atomic_load(&m_remote_identities_snapshot));
+
+	      if(!(snapshot &&
+		   snapshot->generation ==
+		   m_remote_identities_generation.loadAcquire() &&
+		   snapshot->identities.contains(identity)))
+		m_remote_identities_generation.fetchAndAddOrdered(1);
+	    }
+	}
 #endif
-      share_identity(data + m_end_of_message_marker);
+
+      /*
+      ** Other children need not be told of an identity which some child
+      ** shared recently. Peers which join later receive the identities
+      ** of the registry.
+      */
+
+      if(m_identities.publish(identity))
+	share_identity(data + m_end_of_message_marker);
+      else
+	{
+	  m_identity_shares_suppressed += 1;
+	  save_statistic
+	    (spot_on_lite_daemon_statistics::IDENTITY_SHARES_SUPPRESSED,
+	     m_identity_shares_suppressed.fetchAndAddOrdered(0ULL));
+	}
     }
 }
 
 void spot_on_lite_daemon_child::remove_expired_identities(void)
 {
 #ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
-  QWriteLocker lock(&m_remote_identities_mutex);
-  QMutableHashIterator<QByteArray, QDateTime> it(m_remote_identities);
+  /*
+  ** Expire the buckets of the seconds which have exceeded the lifetime.
+  ** The lock is held for a bucket at a time. A bucket lists the
+  ** identities which were recorded during its second. Identities which
+  ** were recorded again since then are found in later buckets.
+  */
+
+  auto now = monotonic_coarse_seconds();
 
-  while(it.hasNext())
+  if(now - m_remote_identities_wheel_tail >
+     static_cast<quint64> (IDENTITIES_WHEEL_SIZE))
+    m_remote_identities_wheel_tail = now - IDENTITIES_WHEEL_SIZE;
+
+  for(; now - m_remote_identities_wheel_tail > m_identity_lifetime;
+      m_remote_identities_wheel_tail++)
     {
-      auto now = QDateTime::currentDateTime().toTime_t();
+      QWriteLocker lock(&m_remote_identities_mutex);
+      QVector<QByteArray> later;
+      auto index = static_cast<int>
+	(m_remote_identities_wheel_tail % IDENTITIES_WHEEL_SIZE);
+      auto removed = false;
 
-      it.next();
+      foreach(const auto &identity, m_remote_identities_wheel.at(index))
+	{
+	  auto time = m_remote_identities.time(identity);
+
+	  if(time == 0)
+	    continue;
 
-      if(now > it.value().toTime_t() && now - it.value().toTime_t() >
-	 m_identity_lifetime)
-	it.remove();
+	  if(now - time > m_identity_lifetime)
+	    {
+	      m_remote_identities.remove(identity);
+	      removed = true;
+	    }
+	  else if(time % IDENTITIES_WHEEL_SIZE ==
+		  static_cast<quint64> (index) &&
+		  time != m_remote_identities_wheel_tail)
+	    later << identity; // A later turn of the wheel.
+	}
+
+      m_remote_identities_wheel[index] = later;
+
+      if(removed)
+	m_remote_identities_generation.fetchAndAddOrdered(1);
     }
 #else
-  auto db_connection_id = db_id();
+  /*
+  ** A child expires its own identities only. Its generation would not
+  ** change if another child removed them.
+  */
 
-  {
-    auto db = QSqlDatabase::addDatabase
-      ("QSQLITE", QString::number(db_connection_id));
+  auto query = spot_on_lite_daemon_database::query
+    (m_remote_identities_file_name,
+     remote_identities_schema(),
+     "DELETE FROM remote_identities WHERE ? - date_time_inserted > ? "
+     "AND pid = ?");
+
+  if(query)
+    {
+      query->addBindValue(QDateTime::currentDateTime().toTime_t());
+      query->addBindValue(m_identity_lifetime);
+      query->addBindValue(m_pid);
 
-    db.setDatabaseName(m_remote_identities_file_name);
+      if(query->exec() && query->numRowsAffected() != 0)
+	m_remote_identities_generation.fetchAndAddOrdered(1);
+    }
+#endif
+}
 
-    if(db.open())
-      {
-	QSqlQuery query(db);
+void spot_on_lite_daemon_child::save_latencies(void)
+{
+  /*
+  ** Publish the percentiles of the latencies recorded since the
+  ** previous call. A stage without samples reports zeros.
+  */
 
-	query.exec
-	  (QString("DELETE FROM remote_identities WHERE "
-		   "%1 - date_time_inserted > %2").
-	   arg(QDateTime::currentDateTime().toTime_t()).
-	   arg(m_identity_lifetime));
-      }
+  if(!m_statistics.is_acquired() || !m_statistics.is_owner())
+    return;
 
-    db.close();
-  }
+  QVector<double> quantiles;
 
-  QSqlDatabase::removeDatabase(QString::number(db_connection_id));
-#endif
+  quantiles << 0.5 << 0.99 << 0.999;
+
+  for(int i = 0; i < ZZZ; i++)
+    {
+      auto percentiles(m_latencies[i].take_percentiles(quantiles));
+
+      for(int j = 0; j < percentiles.size(); j++)
+	m_statistics.set
+	  (static_cast<spot_on_lite_daemon_statistics::Counters>
+	   (spot_on_lite_daemon_statistics::LATENCY_LOCAL_IDENTITY_P50 +
+	    i * quantiles.size() + j),
+	   percentiles.at(j));
+    }
+
+  /*
+  ** The ranks of matched identities, which is to say the number of
+  ** keys which a sequential search would have evaluated.
+  */
+
+  auto percentiles(m_identity_ranks.take_percentiles(quantiles));
+
+  for(int i = 0; i < percentiles.size(); i++)
+    m_statistics.set
+      (static_cast<spot_on_lite_daemon_statistics::Counters>
+       (spot_on_lite_daemon_statistics::IDENTITY_RANK_P50 + i),
+       percentiles.at(i));
 }
 
 void spot_on_lite_daemon_child::save_statistic
 (const QString &key, const QString &value)
 {
-  spot_on_lite_common::save_statistic
-    (key, m_statistics_file_name, value, m_pid, db_id());
+  /*
+  ** Only the latest value of a key is retained. The statistics timer
+  ** writes the dirty keys.
+  */
+
+  QWriteLocker lock(&m_dirty_statistics_mutex);
+
+  m_dirty_statistics[key] = value;
+}
+
+void spot_on_lite_daemon_child::save_statistic
+(const spot_on_lite_daemon_statistics::Counters counter, const quint64 value)
+{
+  /*
+  ** Counters are published in the shared statistics segment. The
+  ** statistics database is the fallback. A child which shares the
+  ** slot of its process adds the growth of its cumulative counters
+  ** and leaves out its gauges.
+  */
+
+  if(m_statistics.is_acquired() && m_statistics.is_owner())
+    m_statistics.set(counter, value);
+  else if(m_statistics.is_acquired())
+    {
+      if(spot_on_lite_daemon_statistics::is_cumulative(counter))
+	{
+	  auto previous = m_shared_counters[counter].
+	    fetchAndStoreOrdered(value);
+
+	  if(value > previous)
+	    m_statistics.add(counter, value - previous);
+	}
+    }
+  else
+    switch(counter)
+      {
+      case spot_on_lite_daemon_statistics::BYTES_ACCUMULATED:
+      case spot_on_lite_daemon_statistics::BYTES_READ:
+      case spot_on_lite_daemon_statistics::BYTES_WRITTEN:
+      case spot_on_lite_daemon_statistics::MEMORY:
+	{
+	  save_statistic
+	    (spot_on_lite_daemon_statistics::counter_name(counter),
+	     QString::number(value));
+	  break;
+	}
+      default:
+	{
+	  break;
+	}
+      }
+}
+
+void spot_on_lite_daemon_child::save_statistics(void)
+{
+  QMap<QString, QString> statistics;
+
+  {
+    QWriteLocker lock(&m_dirty_statistics_mutex);
+
+    statistics.swap(m_dirty_statistics);
+  }
+
+  if(statistics.isEmpty())
+    return;
+
+  auto db(spot_on_lite_daemon_database::
+	  database(m_statistics_file_name, statistics_schema()));
+
+  if(!db.isOpen())
+    return;
+
+  QString columns("");
+  auto query = spot_on_lite_daemon_database::query
+    (m_statistics_file_name,
+     statistics_schema(),
+     "INSERT OR IGNORE INTO statistics (pid) VALUES (?)");
+
+  statistics.remove("pid");
+  db.transaction();
+
+  if(query)
+    {
+      query->addBindValue(m_pid);
+      query->exec();
+    }
+
+  if(!statistics.isEmpty())
+    {
+      QMapIterator<QString, QString> it(statistics);
+
+      while(it.hasNext())
+	{
+	  it.next();
+	  columns.append(it.key());
+	  columns.append(" = ?");
+
+	  if(it.hasNext())
+	    columns.append(", ");
+	}
+
+      query = spot_on_lite_daemon_database::query
+	(m_statistics_file_name,
+	 statistics_schema(),
+	 QString("UPDATE statistics SET %1 WHERE pid = ?").arg(columns));
+
+      if(query)
+	{
+	  it.toFront();
+
+	  while(it.hasNext())
+	    {
+	      it.next();
+	      query->addBindValue(it.value());
+	    }
+
+	  query->addBindValue(m_pid);
+	  query->exec();
+	}
+    }
+
+  db.commit();
+  m_statistics.touch();
+}
+
+void spot_on_lite_daemon_child::send_registered_identities(void)
+{
+  /*
+  ** The Spot-On-Lite peer missed the identities which other children
+  ** shared before it joined. Send it the identities of the registry.
+  */
+
+  auto identities(m_identities.identities());
+  auto type_identity(m_message_types.value("type_identity"));
+
+  for(int i = 0; i < identities.size(); i++)
+    {
+      QByteArray results;
+      auto data(identities.at(i).toBase64() + ";sha-512");
+
+      results.append("POST HTTP/1.1\r\n"
+		     "Content-Length: %1\r\n"
+		     "Content-Type: application/x-www-form-urlencoded\r\n"
+		     "\r\n"
+		     "type=" + type_identity + "&content=%2\r\n"
+		     "\r\n\r\n");
+      results.replace
+	("%1",
+	 QByteArray::number(data.length() +
+			    QString("type=" +
+				    type_identity +
+				    "&content=\r\n\r\n\r\n").length()));
+      results.replace("%2", data);
+      write(results);
+    }
 }
 
 void spot_on_lite_daemon_child::
@@ -1905,9 +2617,8 @@ void spot_on_lite_daemon_child::share_identity(const QByteArray &data)
   if(rc > 0)
     {
       m_bytes_written += static_cast<quint64> (rc);
-      save_statistic
-	("bytes_written",
-	 QString::number(m_bytes_written.fetchAndAddOrdered(0ULL)));
+      save_statistic(spot_on_lite_daemon_statistics::BYTES_WRITTEN,
+		     m_bytes_written.fetchAndAddOrdered(0ULL));
     }
 }
 
@@ -2063,6 +2774,7 @@ void spot_on_lite_daemon_child::slot_connected(void)
 
   setsockopt(sd, SOL_SOCKET, SO_RCVBUF, &m_maximum_accumulated_bytes, optlen);
   setsockopt(sd, SOL_SOCKET, SO_SNDBUF, &m_maximum_accumulated_bytes, optlen);
+  send_registered_identities();
 }
 
 void spot_on_lite_daemon_child::slot_disconnected(void)
@@ -2099,6 +2811,7 @@ void spot_on_lite_daemon_child::slot_general_timer_timeout(void)
     if(QDateTime::currentMSecsSinceEpoch() - m_local_content_last_parsed >
        END_OF_MESSAGE_MARKER_WINDOW)
       {
+	record_dropped_bytes(m_local_content.length());
 	m_local_content.clear();
 	m_local_content_last_parsed = QDateTime::currentMSecsSinceEpoch();
       }
@@ -2107,18 +2820,36 @@ void spot_on_lite_daemon_child::slot_general_timer_timeout(void)
   if(QDateTime::currentMSecsSinceEpoch() - m_remote_content_last_parsed >
      END_OF_MESSAGE_MARKER_WINDOW)
     {
+      record_dropped_bytes(m_remote_content.length());
       m_remote_content.clear();
       m_remote_content_last_parsed = QDateTime::currentMSecsSinceEpoch();
     }
 
-  save_statistic("bytes_accumulated", QString::number(bytes_accumulated()));
+  record_queues();
+  save_latencies();
+
+  if(m_congestion_control.is_attached())
+    {
+      save_statistic
+	(spot_on_lite_daemon_statistics::CONGESTION_CONTROL_DUPLICATES,
+	 m_congestion_control.duplicates());
+      save_statistic
+	(spot_on_lite_daemon_statistics::CONGESTION_CONTROL_FILTER_HITS,
+	 m_congestion_control.filter_hits());
+      save_statistic
+	(spot_on_lite_daemon_statistics::CONGESTION_CONTROL_FILTER_MISSES,
+	 m_congestion_control.filter_misses());
+    }
+  save_statistic(spot_on_lite_daemon_statistics::BYTES_ACCUMULATED,
+		 static_cast<quint64> (bytes_accumulated()));
 
   struct rusage rusage = {};
 
   if(getrusage(RUSAGE_SELF, &rusage) == 0)
-    save_statistic("memory", QString::number(rusage.ru_maxrss));
+    save_statistic(spot_on_lite_daemon_statistics::MEMORY,
+		   static_cast<quint64> (rusage.ru_maxrss));
   else
-    save_statistic("memory", "0");
+    save_statistic(spot_on_lite_daemon_statistics::MEMORY, 0);
 }
 
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 12, 0))
@@ -2216,22 +2947,29 @@ void spot_on_lite_daemon_child::slot_local_socket_ready_read(void)
 
 	    if(m_local_content.length() >= m_maximum_accumulated_bytes)
 	      {
+		record_dropped_bytes(m_local_content.length());
 		m_local_content.clear();
 		m_local_content_last_parsed =
 		  QDateTime::currentMSecsSinceEpoch();
 	      }
 
+	    auto length = m_local_content.length();
+
 	    m_local_content.append
 	      (data.mid(0, qAbs(m_maximum_accumulated_bytes -
 				m_local_content.length())));
+	    m_local_content_received = spot_on_lite_daemon_histogram::now();
+	    record_dropped_bytes
+	      (data.length() - (m_local_content.length() - length));
 	  }
 
 	}
     }
 
-  save_statistic("bytes_accumulated", QString::number(bytes_accumulated()));
-  save_statistic
-    ("bytes_read", QString::number(m_bytes_read.fetchAndAddOrdered(0ULL)));
+  save_statistic(spot_on_lite_daemon_statistics::BYTES_ACCUMULATED,
+		 static_cast<quint64> (bytes_accumulated()));
+  save_statistic(spot_on_lite_daemon_statistics::BYTES_READ,
+		 m_bytes_read.fetchAndAddOrdered(0ULL));
 
   {
     QReadLocker lock(&m_local_content_mutex);
@@ -2254,9 +2992,8 @@ void spot_on_lite_daemon_child::slot_ready_read(void)
       if(data.isEmpty())
 	{
 	  m_bytes_read += static_cast<quint64> (data.length());
-	  save_statistic
-	    ("bytes_read",
-	     QString::number(m_bytes_read.fetchAndAddOrdered(0ULL)));
+	  save_statistic(spot_on_lite_daemon_statistics::BYTES_READ,
+			 m_bytes_read.fetchAndAddOrdered(0ULL));
 	}
 
 #ifdef SPOTON_LITE_DAEMON_DTLS_SUPPORTED
@@ -2326,9 +3063,27 @@ slot_ssl_errors(const QList<QSslError> &errors)
     qobject_cast<QSslSocket *> (m_remote_socket)->ignoreSslErrors();
 }
 
-void spot_on_lite_daemon_child::slot_write_data(const QByteArray &data)
+void spot_on_lite_daemon_child::slot_statistics_timer_timeout(void)
+{
+  {
+    QReadLocker lock(&m_dirty_statistics_mutex);
+
+    if(m_dirty_statistics.isEmpty())
+      return;
+  }
+
+  if(m_statistics_future.isFinished())
+    m_statistics_future = QtConcurrent::run
+      (this, &spot_on_lite_daemon_child::save_statistics);
+}
+
+void spot_on_lite_daemon_child::slot_write_data
+(const QByteArray &data, const qint64 received)
 {
   write(data);
+
+  if(received > 0)
+    m_latencies[LOCAL_TOTAL].record_since(received);
 }
 
 void spot_on_lite_daemon_child::stop_threads_and_timers(void)
@@ -2341,6 +3096,8 @@ void spot_on_lite_daemon_child::stop_threads_and_timers(void)
   m_general_timer.stop();
   m_keep_alive_timer.stop();
   m_process_local_content_future.cancel();
+  m_statistics_future.cancel();
+  m_statistics_timer.stop();
 
   /*
   ** Wait for threads to complete.
@@ -2348,10 +3105,13 @@ void spot_on_lite_daemon_child::stop_threads_and_timers(void)
 
   m_expired_identities_future.waitForFinished();
   m_process_local_content_future.waitForFinished();
+  m_statistics_future.waitForFinished();
 }
 
 void spot_on_lite_daemon_child::write(const QByteArray &data)
 {
+  auto start = spot_on_lite_daemon_histogram::now();
+
   switch(m_protocol)
     {
     case QAbstractSocket::TcpSocket:
@@ -2381,6 +3141,7 @@ void spot_on_lite_daemon_child::write(const QByteArray &data)
 	      break;
 	  }
 
+	record_dropped_bytes(data.size() - i);
 	break;
       }
     case QAbstractSocket::UdpSocket:
@@ -2417,6 +3178,7 @@ void spot_on_lite_daemon_child::write(const QByteArray &data)
 	      break;
 	  }
 
+	record_dropped_bytes(data.size() - i);
 	break;
       }
     default:
@@ -2425,6 +3187,8 @@ void spot_on_lite_daemon_child::write(const QByteArray &data)
       }
     }
 
-  save_statistic("bytes_written",
-		 QString::number(m_bytes_written.fetchAndAddOrdered(0ULL)));
+  m_latencies[LOCAL_WRITE].record_since(start);
+  record_queues();
+  save_statistic(spot_on_lite_daemon_statistics::BYTES_WRITTEN,
+		 m_bytes_written.fetchAndAddOrdered(0ULL));
 }
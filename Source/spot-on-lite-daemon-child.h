@@ -34,6 +34,7 @@ extern "C"
 }
 
 #include <QAbstractSocket>
+#include <QBitArray>
 #ifdef SPOTON_LITE_DAEMON_DTLS_SUPPORTED
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 12, 0))
 #include <QDtls>
@@ -47,9 +48,17 @@ extern "C"
 #include <QReadWriteLock>
 #include <QSslCipher>
 #include <QSslConfiguration>
+#include <QThreadPool>
 #include <QTimer>
 
+#include <memory>
+
+#include "spot-on-lite-daemon-congestion-control.h"
+#include "spot-on-lite-daemon-histogram.h"
+#include "spot-on-lite-daemon-identities.h"
+#include "spot-on-lite-daemon-identities-container.h"
 #include "spot-on-lite-daemon-sha.h"
+#include "spot-on-lite-daemon-statistics.h"
 
 class QLocalSocket;
 
@@ -82,14 +91,50 @@ class spot_on_lite_daemon_child: public QObject
      const quint16 peer_port);
   ~spot_on_lite_daemon_child();
   static bool memcmp(const QByteArray &a, const QByteArray &b);
+  static bool memcmp(const QByteArray &a, const char *b, const int length);
   void data_received(const QByteArray &data,
 		     const QHostAddress &peer_address,
 		     const quint16 peer_port);
 
  private:
+  /*
+  ** The order follows the LATENCY_* statistics counters.
+  */
+
+  enum Latencies
+    {
+     LOCAL_IDENTITY = 0,
+     LOCAL_PARSE = 1,
+     LOCAL_TOTAL = 2,
+     LOCAL_WRITE = 3,
+     REMOTE_CONGESTION = 4,
+     REMOTE_PARSE = 5,
+     REMOTE_TOTAL = 6,
+     REMOTE_WRITE = 7,
+     ZZZ = 8
+    };
+
+  /*
+  ** An immutable view of the remote identities and their prepared keys.
+  ** The keys are ordered by the recent hits of their identities.
+  */
+
+  struct identities_snapshot
+  {
+    QHash<QByteArray, QString> identities;
+    QVector<QByteArray> order; // The identities of the keys.
+    QVector<spot_on_lite_daemon_sha::hmac_key> keys;
+    quint64 generation;
+  };
+
   QAbstractSocket::SocketType m_protocol;
+  QAtomicInteger<quint64> m_bytes_dropped;
   QAtomicInteger<quint64> m_bytes_read;
   QAtomicInteger<quint64> m_bytes_written;
+  QAtomicInteger<quint64> m_identity_shares_suppressed;
+  QAtomicInteger<quint64> m_remote_identities_generation;
+  QAtomicInteger<quint64>
+    m_shared_counters[spot_on_lite_daemon_statistics::ZZZ];
   QByteArray m_end_of_message_marker;
   QByteArray m_local_content;
   QByteArray m_remote_content;
@@ -100,14 +145,15 @@ class spot_on_lite_daemon_child: public QObject
 #endif
   QFuture<void> m_expired_identities_future;
   QFuture<void> m_process_local_content_future;
-#ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
-  QHash<QByteArray, QDateTime> m_remote_identities;
-#endif
+  QFuture<void> m_statistics_future;
+  QHash<QByteArray, spot_on_lite_daemon_sha::hmac_key> m_hmac_keys;
+  QHash<QByteArray, quint64> m_identity_hits;
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 12, 0))
   QHash<QPair<QHostAddress, quint16>, char> m_verified_udp_clients;
 #endif
   QHash<QString, QByteArray> m_message_types;
   QHostAddress m_peer_address;
+  QMap<QString, QString> m_dirty_statistics;
   QLocalSocket m_local_socket;
   QPointer<QAbstractSocket> m_remote_socket;
 #ifdef SPOTON_LITE_DAEMON_DTLS_SUPPORTED
@@ -118,6 +164,7 @@ class spot_on_lite_daemon_child: public QObject
 #ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
   QReadWriteLock m_remote_identities_mutex;
 #endif
+  QReadWriteLock m_dirty_statistics_mutex;
   QSslConfiguration m_ssl_configuration;
   QString m_certificates_file_name;
   QString m_configuration_file_name;
@@ -128,36 +175,63 @@ class spot_on_lite_daemon_child: public QObject
   QString m_server_identity;
   QString m_ssl_control_string;
   QString m_statistics_file_name;
+  QThreadPool m_identities_pool;
   QTimer m_attempt_local_connection_timer;
   QTimer m_attempt_remote_connection_timer;
   QTimer m_capabilities_timer;
   QTimer m_expired_identities_timer;
   QTimer m_general_timer;
   QTimer m_keep_alive_timer;
+  QTimer m_statistics_timer;
+#ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
+  QVector<QVector<QByteArray> > m_remote_identities_wheel;
+#endif
   bool m_client_role;
   bool m_spot_on_lite;
+  int m_identities_matching_threads;
+  int m_identity_matches_since_ranking;
   int m_local_so_rcvbuf_so_sndbuf;
   int m_maximum_accumulated_bytes;
   int m_silence;
   int m_so_linger;
   int m_ssl_key_size;
+  int m_statistics_flush_interval;
   mutable QReadWriteLock m_local_content_mutex;
   qint64 m_pid;
   qint64 m_local_content_last_parsed;
+  qint64 m_local_content_received;
   qint64 m_remote_content_last_parsed;
+  qint64 m_remote_content_received;
   quint16 m_peer_port;
+  quint64 m_identity_hmacs;
+  quint64 m_identity_matches;
+#ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
+  quint64 m_remote_identities_wheel_tail;
+#endif
+  spot_on_lite_daemon_congestion_control m_congestion_control;
+  spot_on_lite_daemon_histogram m_identity_ranks;
+  spot_on_lite_daemon_histogram m_latencies[ZZZ];
+  spot_on_lite_daemon_identities m_identities;
+#ifdef SPOTON_LITE_DAEMON_ENABLE_IDENTITIES_CONTAINER
+  spot_on_lite_daemon_identities_container m_remote_identities;
+#endif
   spot_on_lite_daemon_sha m_sha_512;
-  static QReadWriteLock s_db_id_mutex;
-  static quint64 s_db_id;
+  spot_on_lite_daemon_statistics m_statistics;
+  std::shared_ptr<const identities_snapshot> m_remote_identities_snapshot;
   unsigned int m_identity_lifetime;
+  QBitArray record_congestion(const QVector<QByteArray> &messages);
   QHash<QByteArray, QString> remote_identities(bool *ok);
   QList<QByteArray> local_certificate_configuration(void);
   QList<QSslCipher> default_ssl_ciphers(void) const;
+  QVector<int> match_identities
+    (const QVector<QByteArray> &contents,
+     const QVector<QByteArray> &hashes,
+     const QVector<spot_on_lite_daemon_sha::hmac_key> &keys);
   bool record_congestion(const QByteArray &data);
   int bytes_accumulated(void) const;
   int bytes_in_send_queue(void) const;
-  quint64 db_id(void);
-  void create_remote_identities_database(void);
+  std::shared_ptr<const identities_snapshot> remote_identities_snapshot
+    (void);
   void generate_certificate(RSA *rsa,
 			    QByteArray &certificate,
 			    const long int days,
@@ -179,12 +253,19 @@ class spot_on_lite_daemon_child: public QObject
   void purge_containers(void);
   void purge_remote_identities(void);
   void purge_statistics(void);
+  void record_dropped_bytes(const qint64 bytes);
+  void record_queues(void);
   void record_certificate(const QByteArray &certificate,
 			  const QByteArray &private_key,
 			  const QByteArray &public_key);
   void record_remote_identity(const QByteArray &data);
   void remove_expired_identities(void);
+  void save_latencies(void);
   void save_statistic(const QString &key, const QString &value);
+  void save_statistic(const spot_on_lite_daemon_statistics::Counters counter,
+		      const quint64 value);
+  void save_statistics(void);
+  void send_registered_identities(void);
   void set_ssl_ciphers(const QList<QSslCipher> &ciphers,
 		       QSslConfiguration &configuration) const;
   void share_identity(const QByteArray &data);
@@ -210,11 +291,12 @@ class spot_on_lite_daemon_child: public QObject
   void slot_ready_read(void);
   void slot_remove_expired_identities(void);
   void slot_ssl_errors(const QList<QSslError> &errors);
-  void slot_write_data(const QByteArray &data);
+  void slot_statistics_timer_timeout(void);
+  void slot_write_data(const QByteArray &data, const qint64 received);
 
  signals:
   void read_signal(void);
-  void write_signal(const QByteArray &data);
+  void write_signal(const QByteArray &data, const qint64 received);
 };
 
 #endif
@@ -0,0 +1,691 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+extern "C"
+{
+#include <openssl/rand.h>
+#include <string.h>
+#include <time.h>
+}
+
+#include <QAtomicInteger>
+#include <QCryptographicHash>
+#include <QFile>
+
+#include <cmath>
+
+#include "spot-on-lite-daemon-congestion-control.h"
+#include "spot-on-lite-daemon-siphash.h"
+
+/*
+** An open-addressing table of message digests which is shared by the
+** daemon and its children. Each entry is a single word: a 40-bit
+** fingerprint and a 24-bit insertion time in seconds, relative to the
+** creation of the table. Entries are claimed with compare-and-swap.
+** The home of an entry is derived from bits of the digest which are
+** not part of the fingerprint. The daemon replaces expired entries
+** with tombstones. A full probe sequence admits the message.
+**
+** An optional Bloom filter precedes the table. The filter consists of
+** generations of 64-byte blocks, each generation covering a slice of
+** time. A digest is recorded in the generation of the current slice
+** and tested against all generations. The daemon clears the
+** generation of the following slice ahead of time. The filter is
+** consulted only if the generations of the last three slices were
+** prepared and cover the lifetime of entries. A digest which the
+** filter rules out is appended without searching for a duplicate.
+**
+** Expiration is driven by a wheel of per-second buckets. Children
+** append the position and time of every entry which they claim to a
+** ring of records. The records of a second are contiguous, so the
+** daemon expires whole seconds from the tail of the ring and stops at
+** the first second which has not expired. The cost of a purge is
+** proportional to the number of expired entries. If writers overtake
+** the daemon, the table is swept.
+**
+** Digests are at least sixteen bytes long. By default, the daemon
+** selects SipHash-2-4-128 and a random key which is stored in the
+** header. Unlike the key, the hash function is a property of the
+** table so that all processes agree on the digests of messages.
+**
+** If the daemon examines the messages which it relays, it says so in
+** the header and children admit messages without recording them.
+*/
+
+struct spot_on_lite_daemon_congestion_control_header
+{
+  quint64 magic;
+  quint64 epoch; // Monotonic seconds.
+  quint64 filter_offset;
+  quint64 wheel_offset;
+  quint64 wheel_tail; // Daemon.
+  QBasicAtomicInteger<quint64> wheel_head;
+  quint32 capacity;
+  quint32 version;
+  quint32 filter_blocks; // Per generation.
+  quint32 filter_hashes;
+  quint32 filter_slice; // Seconds.
+  QBasicAtomicInteger<quint32> lifetime;
+  QBasicAtomicInteger<quint32>
+    generations[spot_on_lite_daemon_congestion_control::GENERATIONS];
+  quint32 digest;
+  QBasicAtomicInteger<quint32> hub_deduplication;
+  char key[spot_on_lite_daemon_siphash::KEY_SIZE];
+  char reserved[16];
+};
+
+static_assert(sizeof(spot_on_lite_daemon_congestion_control_header) == 128,
+	      "Irregular congestion control header.");
+static_assert(spot_on_lite_daemon_congestion_control::GENERATIONS == 4,
+	      "The filter requires four generations.");
+
+static const int FILTER_BLOCK_SIZE = 64;
+static const int MAXIMUM_FILTER_HASHES = 16;
+static const int MAXIMUM_PROBES = 64;
+static const int MAXIMUM_RETRIES = 4;
+static const quint32 MAXIMUM_LIFETIME = (1U << 23) - 1;
+static const quint64 EMPTY = 0;
+static const quint64 TIME_MASK = (1ULL << 24) - 1;
+static const quint64 TOMBSTONE = 1;
+static quint64 s_magic = 0x53504f54434f4e47ULL; // SPOTCONG
+static quint32 s_version = 5;
+
+static QBasicAtomicInteger<quint64> *entries_at
+(const spot_on_lite_daemon_shared_memory &shared_memory)
+{
+  return reinterpret_cast<QBasicAtomicInteger<quint64> *>
+    (static_cast<char *> (shared_memory.data()) +
+     sizeof(spot_on_lite_daemon_congestion_control_header));
+}
+
+static spot_on_lite_daemon_congestion_control_header *header_at
+(const spot_on_lite_daemon_shared_memory &shared_memory)
+{
+  return static_cast<spot_on_lite_daemon_congestion_control_header *>
+    (shared_memory.data());
+}
+
+static QBasicAtomicInteger<quint64> *filter_block_at
+(const spot_on_lite_daemon_shared_memory &shared_memory,
+ const quint64 generation,
+ const quint64 block)
+{
+  auto header = header_at(shared_memory);
+
+  return reinterpret_cast<QBasicAtomicInteger<quint64> *>
+    (static_cast<char *> (shared_memory.data()) +
+     header->filter_offset +
+     (generation * header->filter_blocks + block) * FILTER_BLOCK_SIZE);
+}
+
+static QBasicAtomicInteger<quint64> *wheel_at
+(const spot_on_lite_daemon_shared_memory &shared_memory)
+{
+  return reinterpret_cast<QBasicAtomicInteger<quint64> *>
+    (static_cast<char *> (shared_memory.data()) +
+     header_at(shared_memory)->wheel_offset);
+}
+
+static quint64 monotonic_seconds(void)
+{
+  struct timespec ts = {};
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<quint64> (ts.tv_sec);
+}
+
+spot_on_lite_daemon_congestion_control::
+spot_on_lite_daemon_congestion_control(void)
+{
+  m_duplicates = 0;
+  m_filter_hits = 0;
+  m_filter_misses = 0;
+}
+
+spot_on_lite_daemon_congestion_control::
+~spot_on_lite_daemon_congestion_control()
+{
+  detach();
+}
+
+QString spot_on_lite_daemon_congestion_control::file_name
+(const QString &congestion_control_file_name)
+{
+  return congestion_control_file_name + ".shm";
+}
+
+bool spot_on_lite_daemon_congestion_control::attach(const QString &file_name)
+{
+  detach();
+
+  if(!m_shared_memory.attach(file_name, false))
+    return false;
+
+  auto header = header_at(m_shared_memory);
+
+  if(m_shared_memory.size() < sizeof(*header) ||
+     header->magic != s_magic ||
+     header->version != s_version ||
+     header->capacity == 0 ||
+     header->digest > SIPHASH_2_4_128 ||
+     (header->capacity & (header->capacity - 1)) != 0 ||
+     (header->filter_blocks & (header->filter_blocks - 1)) != 0 ||
+     m_shared_memory.size() < sizeof(*header) +
+     2 * static_cast<size_t> (header->capacity) * sizeof(quint64) +
+     static_cast<size_t> (GENERATIONS) * header->filter_blocks *
+     FILTER_BLOCK_SIZE)
+    {
+      m_shared_memory.detach();
+      return false;
+    }
+
+  return true;
+}
+
+bool spot_on_lite_daemon_congestion_control::create
+(const QString &file_name,
+ const int capacity,
+ const int lifetime,
+ const qint64 filter_memory,
+ const double false_positive_rate,
+ const Digests digest)
+{
+  detach();
+
+  char key[spot_on_lite_daemon_siphash::KEY_SIZE];
+
+  if(digest == SIPHASH_2_4_128 &&
+     RAND_bytes(reinterpret_cast<unsigned char *> (key),
+		static_cast<int> (sizeof(key))) != 1)
+    return false;
+
+  /*
+  ** The capacity is rounded up to a power of two.
+  */
+
+  auto c = static_cast<quint32> (MINIMUM_CAPACITY);
+  auto maximum = static_cast<quint32> (MAXIMUM_CAPACITY);
+
+  while(c < maximum && c < static_cast<quint32> (capacity))
+    c <<= 1;
+
+  /*
+  ** The number of blocks of a generation is the greatest power of two
+  ** which respects the memory budget. The rate determines the number
+  ** of bits which are set per digest.
+  */
+
+  auto memory = qMin
+    (filter_memory, static_cast<qint64> (MAXIMUM_FILTER_MEMORY));
+  quint32 blocks = 0;
+  quint32 hashes = 0;
+
+  if(memory >= GENERATIONS * FILTER_BLOCK_SIZE &&
+     false_positive_rate > 0.0 &&
+     false_positive_rate < 1.0)
+    {
+      blocks = 1;
+
+      while(static_cast<qint64> (2 * blocks) * GENERATIONS *
+	    FILTER_BLOCK_SIZE <= memory)
+	blocks <<= 1;
+
+      hashes = static_cast<quint32>
+	(qBound(1.0,
+		std::ceil(-std::log2(false_positive_rate)),
+		static_cast<double> (MAXIMUM_FILTER_HASHES)));
+    }
+
+  if(!m_shared_memory.
+     create(file_name,
+	    sizeof(spot_on_lite_daemon_congestion_control_header) +
+	    2 * static_cast<size_t> (c) * sizeof(quint64) +
+	    static_cast<size_t> (GENERATIONS) * blocks * FILTER_BLOCK_SIZE))
+    return false;
+
+  /*
+  ** The file is zero-filled, which is to say empty.
+  */
+
+  auto header = header_at(m_shared_memory);
+
+  header->capacity = c;
+  header->digest = static_cast<quint32> (digest);
+  header->epoch = monotonic_seconds();
+  header->filter_blocks = blocks;
+  header->filter_hashes = hashes;
+  header->filter_offset =
+    sizeof(spot_on_lite_daemon_congestion_control_header) +
+    static_cast<quint64> (c) * sizeof(quint64);
+  header->wheel_offset = header->filter_offset +
+    static_cast<quint64> (GENERATIONS) * blocks * FILTER_BLOCK_SIZE;
+
+  /*
+  ** Two slices of the four generations cover the lifetime. The daemon
+  ** must be able to prepare every slice.
+  */
+
+  header->filter_slice = static_cast<quint32>
+    (qMax(30, (qBound(1, lifetime, static_cast<int> (MAXIMUM_LIFETIME)) +
+	       GENERATIONS - 3) / (GENERATIONS - 2)));
+  header->generations[0].storeRelease(1);
+  header->lifetime.storeRelease
+    (static_cast<quint32>
+     (qBound(1, lifetime, static_cast<int> (MAXIMUM_LIFETIME))));
+
+  if(digest == SIPHASH_2_4_128)
+    memcpy(header->key, key, sizeof(key));
+
+  memset(key, 0, sizeof(key));
+  header->version = s_version;
+  header->magic = s_magic;
+  rotate();
+  return true;
+}
+
+QByteArray spot_on_lite_daemon_congestion_control::digest
+(const QByteArray &data) const
+{
+  if(is_attached() &&
+     header_at(m_shared_memory)->digest == SIPHASH_2_4_128)
+    {
+      QByteArray digest(16, 0);
+
+      spot_on_lite_daemon_siphash::siphash_2_4_128
+	(header_at(m_shared_memory)->key,
+	 data.constData(),
+	 static_cast<size_t> (data.length()),
+	 digest.data());
+      return digest;
+    }
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 1, 0))
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha3_384);
+#else
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha384);
+#endif
+}
+
+bool spot_on_lite_daemon_congestion_control::hub_deduplication(void) const
+{
+  return is_attached() &&
+    header_at(m_shared_memory)->hub_deduplication.loadAcquire() != 0;
+}
+
+bool spot_on_lite_daemon_congestion_control::insert(const QByteArray &digest)
+{
+  /*
+  ** Returns true if the digest was absent or expired.
+  */
+
+  if(!is_attached() || digest.length() < 16)
+    return true;
+
+  auto entries = entries_at(m_shared_memory);
+  auto header = header_at(m_shared_memory);
+  auto lifetime = header->lifetime.loadAcquire();
+  auto mask = static_cast<quint64> (header->capacity - 1);
+  auto n = static_cast<quint64> (now());
+  quint64 fingerprint = 0;
+  quint64 home = 0;
+
+  memcpy(&home, digest.constData(), sizeof(home));
+  memcpy(&fingerprint, digest.constData() + sizeof(home), 5);
+  fingerprint &= (1ULL << 40) - 1;
+
+  if(fingerprint == 0)
+    fingerprint = 1;
+
+  auto entry = (fingerprint << 24) | (n & TIME_MASK);
+  auto filtered = rule_out(digest);
+
+  for(int retry = 0; retry < MAXIMUM_RETRIES; retry++)
+    {
+      quint64 expected = EMPTY;
+      qint64 target = -1;
+
+      for(int i = 0; i < MAXIMUM_PROBES; i++)
+	{
+	  auto index = (home + static_cast<quint64> (i)) & mask;
+	  auto value = entries[index].loadAcquire();
+
+	  if(value == EMPTY)
+	    {
+	      if(target < 0)
+		{
+		  expected = value;
+		  target = static_cast<qint64> (index);
+		}
+
+	      break;
+	    }
+
+	  auto expired = value == TOMBSTONE ||
+	    ((n - (value & TIME_MASK)) & TIME_MASK) >= lifetime;
+
+	  if((value >> 24) == fingerprint && !expired)
+	    {
+	      m_duplicates += 1;
+	      return false;
+	    }
+
+	  if(expired && target < 0)
+	    {
+	      expected = value;
+	      target = static_cast<qint64> (index);
+	    }
+
+	  if(filtered && target >= 0)
+	    break; // Append.
+	}
+
+      if(target < 0)
+	return true; // Full.
+
+      if(entries[target].testAndSetOrdered(expected, entry))
+	{
+	  auto position = header->wheel_head.fetchAndAddOrdered(1);
+
+	  wheel_at(m_shared_memory)[position & mask].storeRelease
+	    (((static_cast<quint64> (target) + 1) << 24) | (n & TIME_MASK));
+	  return true;
+	}
+
+      filtered = false;
+    }
+
+  return true;
+}
+
+bool spot_on_lite_daemon_congestion_control::is_attached(void) const
+{
+  return m_shared_memory.is_attached();
+}
+
+int spot_on_lite_daemon_congestion_control::capacity(void) const
+{
+  if(!is_attached())
+    return 0;
+
+  return static_cast<int> (header_at(m_shared_memory)->capacity);
+}
+
+bool spot_on_lite_daemon_congestion_control::rule_out
+(const QByteArray &digest)
+{
+  /*
+  ** Records the digest in the current generation. Returns true if the
+  ** digest is certainly absent from the table.
+  */
+
+  auto header = header_at(m_shared_memory);
+
+  if(digest.length() < 16 || header->filter_blocks == 0)
+    return false;
+
+  auto slice = (monotonic_seconds() - header->epoch) / header->filter_slice;
+  auto trusted = header->lifetime.loadAcquire() <=
+    (GENERATIONS - 2) * header->filter_slice;
+
+  for(quint64 i = 0; i < GENERATIONS - 1 && i <= slice; i++)
+    if(header->generations[(slice - i) % GENERATIONS].loadAcquire() !=
+       static_cast<quint32> (slice - i + 1))
+      trusted = false;
+
+  /*
+  ** The block is selected by the upper half of the word which homes
+  ** the entry. The table consumes at most the lower half.
+  */
+
+  quint64 a = 0;
+  quint64 b = 0;
+
+  memcpy(&a, digest.constData(), sizeof(a));
+  memcpy(&b, digest.constData() + 8, sizeof(b));
+
+  auto block = (a >> 32) & static_cast<quint64> (header->filter_blocks - 1);
+  auto present = false;
+  auto step = (b >> 32) | 1;
+  quint64 bits[FILTER_BLOCK_SIZE / sizeof(quint64)] = {};
+
+  for(quint32 i = 0; i < header->filter_hashes; i++)
+    {
+      auto bit = (b + i * step) & (8 * FILTER_BLOCK_SIZE - 1);
+
+      bits[bit / 64] |= static_cast<quint64> (1) << (bit % 64);
+    }
+
+  for(quint64 i = 0; i < GENERATIONS && !present; i++)
+    {
+      auto words = filter_block_at(m_shared_memory, i, block);
+
+      present = true;
+
+      for(size_t j = 0; j < sizeof(bits) / sizeof(bits[0]); j++)
+	if((words[j].loadAcquire() & bits[j]) != bits[j])
+	  {
+	    present = false;
+	    break;
+	  }
+    }
+
+  auto words = filter_block_at(m_shared_memory, slice % GENERATIONS, block);
+
+  for(size_t i = 0; i < sizeof(bits) / sizeof(bits[0]); i++)
+    if(bits[i] && (words[i].loadAcquire() & bits[i]) != bits[i])
+      words[i].fetchAndOrOrdered(bits[i]);
+
+  if(present)
+    m_filter_hits += 1;
+  else
+    m_filter_misses += 1;
+
+  return trusted && !present;
+}
+
+int spot_on_lite_daemon_congestion_control::purge(void)
+{
+  /*
+  ** Expire the buckets of the seconds which have exceeded the
+  ** lifetime. Only the daemon purges.
+  */
+
+  if(!is_attached())
+    return 0;
+
+  auto entries = entries_at(m_shared_memory);
+  auto header = header_at(m_shared_memory);
+  auto head = header->wheel_head.loadAcquire();
+  auto lifetime = header->lifetime.loadAcquire();
+  auto mask = static_cast<quint64> (header->capacity - 1);
+  auto n = static_cast<quint64> (now());
+  auto tail = header->wheel_tail;
+  auto wheel = wheel_at(m_shared_memory);
+  int count = 0;
+
+  if(head - tail > mask + 1)
+    {
+      /*
+      ** Records were overwritten.
+      */
+
+      count += sweep();
+      tail = head - (mask + 1);
+    }
+
+  for(; tail < head; tail++)
+    {
+      auto record = wheel[tail & mask].loadAcquire();
+
+      if(record == 0)
+	break; // Not yet written.
+
+      auto time = record & TIME_MASK;
+
+      if(((n - time) & TIME_MASK) < lifetime)
+	break;
+
+      auto index = (record >> 24) - 1;
+      auto value = entries[index].loadAcquire();
+
+      if(value != EMPTY &&
+	 value != TOMBSTONE &&
+	 (value & TIME_MASK) == time &&
+	 entries[index].testAndSetOrdered(value, TOMBSTONE))
+	{
+	  count += 1;
+
+	  /*
+	  ** Tombstones which precede an empty entry terminate no probe
+	  ** sequences.
+	  */
+
+	  if(entries[(index + 1) & mask].loadAcquire() == EMPTY)
+	    for(auto i = index;
+		entries[i].testAndSetOrdered(TOMBSTONE, EMPTY);
+		i = (i - 1) & mask)
+	      ;
+	}
+
+      wheel[tail & mask].testAndSetOrdered(record, 0);
+    }
+
+  header->wheel_tail = tail;
+  return count;
+}
+
+int spot_on_lite_daemon_congestion_control::sweep(void)
+{
+  /*
+  ** Expired entries become tombstones. Tombstones which precede an
+  ** empty entry are emptied.
+  */
+
+  auto entries = entries_at(m_shared_memory);
+  auto header = header_at(m_shared_memory);
+  auto lifetime = header->lifetime.loadAcquire();
+  auto mask = static_cast<quint64> (header->capacity - 1);
+  auto n = static_cast<quint64> (now());
+  int count = 0;
+
+  for(quint64 i = 0; i <= mask; i++)
+    {
+      auto value = entries[i].loadAcquire();
+
+      if(value == EMPTY || value == TOMBSTONE)
+	continue;
+
+      if(((n - (value & TIME_MASK)) & TIME_MASK) >= lifetime &&
+	 entries[i].testAndSetOrdered(value, TOMBSTONE))
+	count += 1;
+    }
+
+  for(quint64 i = mask + 1; i > 0; i--)
+    {
+      auto index = i - 1;
+
+      if(entries[index].loadAcquire() == TOMBSTONE &&
+	 entries[(index + 1) & mask].loadAcquire() == EMPTY)
+	entries[index].testAndSetOrdered(TOMBSTONE, EMPTY);
+    }
+
+  return count;
+}
+
+quint64 spot_on_lite_daemon_congestion_control::duplicates(void) const
+{
+  return m_duplicates;
+}
+
+quint64 spot_on_lite_daemon_congestion_control::filter_hits(void) const
+{
+  return m_filter_hits;
+}
+
+quint64 spot_on_lite_daemon_congestion_control::filter_misses(void) const
+{
+  return m_filter_misses;
+}
+
+quint32 spot_on_lite_daemon_congestion_control::now(void) const
+{
+  return static_cast<quint32>
+    ((monotonic_seconds() - header_at(m_shared_memory)->epoch) & TIME_MASK);
+}
+
+void spot_on_lite_daemon_congestion_control::detach(void)
+{
+  m_shared_memory.detach();
+}
+
+void spot_on_lite_daemon_congestion_control::rotate(void)
+{
+  /*
+  ** Prepare the generation of the following slice. The slice is at
+  ** least as long as the interval of the daemon's timer.
+  */
+
+  if(!is_attached())
+    return;
+
+  auto header = header_at(m_shared_memory);
+
+  if(header->filter_blocks == 0)
+    return;
+
+  auto next = (monotonic_seconds() - header->epoch) /
+    header->filter_slice + 1;
+  auto &generation = header->generations[next % GENERATIONS];
+
+  if(generation.loadAcquire() == static_cast<quint32> (next + 1))
+    return;
+
+  for(quint32 i = 0; i < header->filter_blocks; i++)
+    {
+      auto words = filter_block_at(m_shared_memory, next % GENERATIONS, i);
+
+      for(size_t j = 0; j < FILTER_BLOCK_SIZE / sizeof(quint64); j++)
+	words[j].storeRelaxed(0);
+    }
+
+  generation.storeRelease(static_cast<quint32> (next + 1));
+}
+
+void spot_on_lite_daemon_congestion_control::set_hub_deduplication
+(const bool state)
+{
+  if(is_attached())
+    header_at(m_shared_memory)->hub_deduplication.storeRelease(state ? 1 : 0);
+}
+
+void spot_on_lite_daemon_congestion_control::set_lifetime(const int lifetime)
+{
+  if(is_attached())
+    header_at(m_shared_memory)->lifetime.storeRelease
+      (static_cast<quint32> (qBound(1, lifetime,
+				    static_cast<int> (MAXIMUM_LIFETIME))));
+}
@@ -0,0 +1,82 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _spot_on_lite_daemon_congestion_control_h_
+#define _spot_on_lite_daemon_congestion_control_h_
+
+#include <QByteArray>
+
+#include "spot-on-lite-daemon-shared-memory.h"
+
+class spot_on_lite_daemon_congestion_control
+{
+ public:
+  enum Digests
+    {
+     SHA3_384 = 0,
+     SIPHASH_2_4_128 = 1
+    };
+
+  static const int GENERATIONS = 4;
+  static const int MAXIMUM_CAPACITY = 1 << 26;
+  static const int MINIMUM_CAPACITY = 1 << 10;
+  static const qint64 MAXIMUM_FILTER_MEMORY = 1LL << 30;
+  spot_on_lite_daemon_congestion_control(void);
+  ~spot_on_lite_daemon_congestion_control();
+  QByteArray digest(const QByteArray &data) const;
+  static QString file_name(const QString &congestion_control_file_name);
+  bool attach(const QString &file_name);
+  bool create(const QString &file_name,
+	      const int capacity,
+	      const int lifetime,
+	      const qint64 filter_memory,
+	      const double false_positive_rate,
+	      const Digests digest);
+  bool hub_deduplication(void) const;
+  bool insert(const QByteArray &digest);
+  bool is_attached(void) const;
+  int capacity(void) const;
+  int purge(void);
+  quint64 duplicates(void) const;
+  quint64 filter_hits(void) const;
+  quint64 filter_misses(void) const;
+  void detach(void);
+  void rotate(void);
+  void set_hub_deduplication(const bool state);
+  void set_lifetime(const int lifetime);
+
+ private:
+  quint64 m_duplicates;
+  quint64 m_filter_hits;
+  quint64 m_filter_misses;
+  spot_on_lite_daemon_shared_memory m_shared_memory;
+  bool rule_out(const QByteArray &digest);
+  int sweep(void);
+  quint32 now(void) const;
+};
+
+#endif
@@ -0,0 +1,182 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QAtomicInteger>
+#include <QHash>
+#include <QPair>
+#include <QThreadStorage>
+
+#include "spot-on-lite-daemon-database.h"
+
+/*
+** Each thread owns one open connection per database file. Connections
+** and their prepared queries are released when their thread exits.
+** A thread also releases them when it finds that the generation has
+** changed since they were opened, that is, after clear().
+*/
+
+class spot_on_lite_daemon_database_connections
+{
+ public:
+  QHash<QPair<QString, QString>, QSqlQuery *> m_queries;
+  QHash<QString, QString> m_connection_names;
+  quint64 m_generation;
+
+  spot_on_lite_daemon_database_connections(const quint64 generation)
+  {
+    m_generation = generation;
+  }
+
+  ~spot_on_lite_daemon_database_connections()
+  {
+    close();
+  }
+
+  void close(void)
+  {
+    qDeleteAll(m_queries);
+    m_queries.clear();
+
+    foreach(const auto &connection_name, m_connection_names)
+      {
+	{
+	  auto db = QSqlDatabase::database(connection_name, false);
+
+	  db.close();
+	}
+
+	QSqlDatabase::removeDatabase(connection_name);
+      }
+
+    m_connection_names.clear();
+  }
+};
+
+static QAtomicInteger<quint64> s_connection_id = 0;
+static QAtomicInteger<quint64> s_generation = 0;
+static QThreadStorage<spot_on_lite_daemon_database_connections *>
+s_connections;
+
+static spot_on_lite_daemon_database_connections *connections(void)
+{
+  auto generation = s_generation.loadAcquire();
+
+  if(!s_connections.hasLocalData())
+    s_connections.setLocalData
+      (new spot_on_lite_daemon_database_connections(generation));
+
+  auto c = s_connections.localData();
+
+  if(c->m_generation != generation)
+    {
+      /*
+      ** The files may have been removed. The connections would
+      ** otherwise continue with the unlinked files.
+      */
+
+      c->close();
+      c->m_generation = generation;
+    }
+
+  return c;
+}
+
+void spot_on_lite_daemon_database::clear(void)
+{
+  s_generation.fetchAndAddOrdered(1);
+}
+
+QSqlDatabase spot_on_lite_daemon_database::database
+(const QString &file_name, const QStringList &schema)
+{
+  auto c = connections();
+
+  if(c->m_connection_names.contains(file_name))
+    return QSqlDatabase::database
+      (c->m_connection_names.value(file_name), false);
+
+  auto connection_name
+    (QString("spot_on_lite_daemon_database_%1").
+     arg(s_connection_id.fetchAndAddOrdered(1)));
+
+  {
+    auto db = QSqlDatabase::addDatabase("QSQLITE", connection_name);
+
+    db.setDatabaseName(file_name);
+
+    if(db.open())
+      {
+	/*
+	** The schema and the pragmas are applied once per connection.
+	*/
+
+	QSqlQuery query(db);
+
+	foreach(const auto &statement, schema)
+	  query.exec(statement);
+
+	c->m_connection_names[file_name] = connection_name;
+	return db;
+      }
+  }
+
+  QSqlDatabase::removeDatabase(connection_name);
+  return QSqlDatabase();
+}
+
+QSqlQuery *spot_on_lite_daemon_database::query
+(const QString &file_name,
+ const QStringList &schema,
+ const QString &statement)
+{
+  auto c = connections();
+  auto key(qMakePair(file_name, statement));
+  auto query = c->m_queries.value(key, nullptr);
+
+  if(query)
+    {
+      query->finish();
+      return query;
+    }
+
+  auto db(database(file_name, schema));
+
+  if(!db.isOpen())
+    return nullptr;
+
+  query = new QSqlQuery(db);
+  query->setForwardOnly(true);
+
+  if(!query->prepare(statement))
+    {
+      delete query;
+      return nullptr;
+    }
+
+  c->m_queries[key] = query;
+  return query;
+}
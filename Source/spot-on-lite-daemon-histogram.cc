@@ -0,0 +1,134 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+extern "C"
+{
+#include <time.h>
+}
+
+#include <cmath>
+
+#include "spot-on-lite-daemon-histogram.h"
+
+spot_on_lite_daemon_histogram::spot_on_lite_daemon_histogram(void)
+{
+  for(int i = 0; i < BUCKETS; i++)
+    m_buckets[i].storeRelease(0);
+}
+
+QVector<quint64> spot_on_lite_daemon_histogram::take_percentiles
+(const QVector<double> &quantiles)
+{
+  /*
+  ** Drain the buckets. Samples recorded concurrently are retained for
+  ** the next window.
+  */
+
+  QVector<quint64> buckets(BUCKETS, 0);
+  QVector<quint64> percentiles(quantiles.size(), 0);
+  quint64 count = 0;
+
+  for(int i = 0; i < BUCKETS; i++)
+    if(m_buckets[i].loadAcquire() > 0)
+      {
+	buckets[i] = m_buckets[i].fetchAndStoreOrdered(0);
+	count += buckets[i];
+      }
+
+  if(count == 0)
+    return percentiles;
+
+  for(int i = 0; i < quantiles.size(); i++)
+    {
+      auto rank = static_cast<quint64>
+	(std::ceil(qBound(0.0, quantiles.at(i), 1.0) *
+		   static_cast<double> (count)));
+      quint64 cumulative = 0;
+
+      rank = qMax(static_cast<quint64> (1), rank);
+
+      for(int j = 0; j < BUCKETS; j++)
+	{
+	  cumulative += buckets.at(j);
+
+	  if(cumulative >= rank)
+	    {
+	      percentiles[i] = value(j);
+	      break;
+	    }
+	}
+    }
+
+  return percentiles;
+}
+
+int spot_on_lite_daemon_histogram::bucket(const quint64 value)
+{
+  if(value < 16)
+    return static_cast<int> (value);
+
+  auto exponent = 63 - __builtin_clzll(value); // 4 <= exponent <= 63.
+  auto sub_bucket = static_cast<int> ((value >> (exponent - 3)) & 7);
+
+  return 16 + 8 * (exponent - 4) + sub_bucket;
+}
+
+qint64 spot_on_lite_daemon_histogram::now(void)
+{
+  struct timespec ts = {};
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<qint64> (ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+quint64 spot_on_lite_daemon_histogram::value(const int bucket)
+{
+  /*
+  ** The midpoint of the bucket.
+  */
+
+  if(bucket < 16)
+    return static_cast<quint64> (bucket);
+
+  auto exponent = 4 + (bucket - 16) / 8;
+  auto sub_bucket = static_cast<quint64> ((bucket - 16) % 8);
+  auto width = static_cast<quint64> (1) << (exponent - 3);
+
+  return (8 + sub_bucket) * width + width / 2;
+}
+
+void spot_on_lite_daemon_histogram::record(const qint64 nanoseconds)
+{
+  auto value = nanoseconds > 0 ? static_cast<quint64> (nanoseconds) : 0;
+
+  m_buckets[bucket(value)].fetchAndAddRelaxed(1);
+}
+
+void spot_on_lite_daemon_histogram::record_since(const qint64 start)
+{
+  record(now() - start);
+}
@@ -0,0 +1,59 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _spot_on_lite_daemon_histogram_h_
+#define _spot_on_lite_daemon_histogram_h_
+
+#include <QAtomicInteger>
+#include <QVector>
+
+/*
+** Log-linear histogram of nanosecond durations. Values below 16 have
+** exact buckets. Each following power of two is divided into eight
+** buckets, a relative error of at most 12.5%.
+*/
+
+class spot_on_lite_daemon_histogram
+{
+ public:
+  static const int BUCKETS = 16 + 60 * 8;
+  spot_on_lite_daemon_histogram(void);
+  QVector<quint64> take_percentiles(const QVector<double> &quantiles);
+  static qint64 now(void);
+  void record(const qint64 nanoseconds);
+  void record_since(const qint64 start);
+
+ private:
+  QAtomicInteger<quint64> m_buckets[BUCKETS];
+  spot_on_lite_daemon_histogram(const spot_on_lite_daemon_histogram &other);
+  spot_on_lite_daemon_histogram &operator=
+    (const spot_on_lite_daemon_histogram &other);
+  static int bucket(const quint64 value);
+  static quint64 value(const int bucket);
+};
+
+#endif
@@ -0,0 +1,273 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+extern "C"
+{
+#include <string.h>
+}
+
+#include <QHash>
+
+#include "spot-on-lite-daemon-identities-container.h"
+
+/*
+** A fixed-capacity table of remote identities. The identities occupy
+** contiguous 64-byte slots. An open-addressing index of at least twice
+** the capacity maps identities to slots. If the table is full, the
+** CLOCK hand evicts the first identity which has not been seen since
+** the hand last passed it.
+*/
+
+static const quint8 FREE = 0;
+static const quint8 OCCUPIED = 1;
+static const quint8 REFERENCED = 2;
+
+spot_on_lite_daemon_identities_container::
+spot_on_lite_daemon_identities_container(void)
+{
+  m_evictions = 0;
+  m_hand = 0;
+  m_size = 0;
+}
+
+QList<QByteArray> spot_on_lite_daemon_identities_container::identities
+(void) const
+{
+  QList<QByteArray> list;
+
+  for(int i = 0; i < m_states.size(); i++)
+    if(m_states.at(i) != FREE)
+      list << QByteArray(m_keys.constData() + i * IDENTITY_SIZE,
+			 IDENTITY_SIZE);
+
+  return list;
+}
+
+bool spot_on_lite_daemon_identities_container::contains
+(const QByteArray &identity) const
+{
+  return find(identity, qHash(identity)) >= 0;
+}
+
+bool spot_on_lite_daemon_identities_container::insert
+(const QByteArray &identity, const quint64 time)
+{
+  /*
+  ** Returns true if the identity is new.
+  */
+
+  if(identity.length() != IDENTITY_SIZE || m_states.isEmpty())
+    return false;
+
+  auto hash = qHash(identity);
+  auto position = find(identity, hash);
+
+  if(position >= 0)
+    {
+      auto slot = m_index.at(position) - 1;
+
+      m_states[slot] = REFERENCED;
+      m_times[slot] = time;
+      return false;
+    }
+
+  int slot = 0;
+
+  if(m_free.isEmpty())
+    {
+      while(m_states.at(m_hand) == REFERENCED)
+	{
+	  m_states[m_hand] = OCCUPIED;
+	  m_hand = (m_hand + 1) % m_states.size();
+	}
+
+      slot = m_hand;
+      m_hand = (m_hand + 1) % m_states.size();
+      erase
+	(find(QByteArray::fromRawData(m_keys.constData() +
+				      slot * IDENTITY_SIZE,
+				      IDENTITY_SIZE),
+	      m_hashes.at(slot)));
+      m_evictions += 1;
+      m_size -= 1;
+    }
+  else
+    slot = m_free.takeLast();
+
+  auto mask = m_index.size() - 1;
+
+  position = static_cast<int> (hash) & mask;
+
+  while(m_index.at(position) != 0)
+    position = (position + 1) & mask;
+
+  m_hashes[slot] = hash;
+  m_index[position] = slot + 1;
+  m_size += 1;
+  m_states[slot] = REFERENCED;
+  m_times[slot] = time;
+  memcpy(m_keys.data() + slot * IDENTITY_SIZE,
+	 identity.constData(),
+	 static_cast<size_t> (IDENTITY_SIZE));
+  return true;
+}
+
+int spot_on_lite_daemon_identities_container::capacity(void) const
+{
+  return m_states.size();
+}
+
+int spot_on_lite_daemon_identities_container::find
+(const QByteArray &identity, const uint hash) const
+{
+  /*
+  ** Returns the position of the identity in the index or -1.
+  */
+
+  if(identity.length() != IDENTITY_SIZE || m_index.isEmpty())
+    return -1;
+
+  auto mask = m_index.size() - 1;
+
+  for(int i = 0; i < m_index.size(); i++)
+    {
+      auto position = (static_cast<int> (hash) + i) & mask;
+      auto slot = m_index.at(position) - 1;
+
+      if(slot < 0)
+	break;
+
+      if(m_hashes.at(slot) == hash &&
+	 memcmp(m_keys.constData() + slot * IDENTITY_SIZE,
+		identity.constData(),
+		static_cast<size_t> (IDENTITY_SIZE)) == 0)
+	return position;
+    }
+
+  return -1;
+}
+
+int spot_on_lite_daemon_identities_container::size(void) const
+{
+  return m_size;
+}
+
+quint64 spot_on_lite_daemon_identities_container::evictions(void) const
+{
+  return m_evictions;
+}
+
+quint64 spot_on_lite_daemon_identities_container::time
+(const QByteArray &identity) const
+{
+  auto position = find(identity, qHash(identity));
+
+  if(position < 0)
+    return 0;
+
+  return m_times.at(m_index.at(position) - 1);
+}
+
+void spot_on_lite_daemon_identities_container::clear(void)
+{
+  m_free.clear();
+  m_hand = 0;
+  m_index.fill(0);
+  m_size = 0;
+  m_states.fill(FREE);
+
+  for(int i = m_states.size() - 1; i >= 0; i--)
+    m_free << i;
+}
+
+void spot_on_lite_daemon_identities_container::erase(int position)
+{
+  /*
+  ** Entries which follow the position are shifted back so that no
+  ** probe sequence is interrupted.
+  */
+
+  if(position < 0)
+    return;
+
+  auto mask = m_index.size() - 1;
+  auto next = position;
+
+  m_index[position] = 0;
+
+  for(;;)
+    {
+      next = (next + 1) & mask;
+
+      auto slot = m_index.at(next) - 1;
+
+      if(slot < 0)
+	break;
+
+      auto home = static_cast<int> (m_hashes.at(slot)) & mask;
+
+      if(((next - home) & mask) >= ((next - position) & mask))
+	{
+	  m_index[position] = slot + 1;
+	  m_index[next] = 0;
+	  position = next;
+	}
+    }
+}
+
+void spot_on_lite_daemon_identities_container::remove
+(const QByteArray &identity)
+{
+  auto position = find(identity, qHash(identity));
+
+  if(position < 0)
+    return;
+
+  auto slot = m_index.at(position) - 1;
+
+  erase(position);
+  m_free << slot;
+  m_size -= 1;
+  m_states[slot] = FREE;
+}
+
+void spot_on_lite_daemon_identities_container::set_capacity
+(const int capacity)
+{
+  auto c = qMax(1, capacity);
+  int n = 1;
+
+  while(n < 2 * c)
+    n <<= 1;
+
+  m_hashes.fill(0, c);
+  m_index.fill(0, n);
+  m_keys.fill(0, c * IDENTITY_SIZE);
+  m_states.fill(FREE, c);
+  m_times.fill(0, c);
+  clear();
+}
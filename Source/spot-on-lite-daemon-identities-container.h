@@ -0,0 +1,65 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _spot_on_lite_daemon_identities_container_h_
+#define _spot_on_lite_daemon_identities_container_h_
+
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+
+class spot_on_lite_daemon_identities_container
+{
+ public:
+  static const int IDENTITY_SIZE = 64;
+  spot_on_lite_daemon_identities_container(void);
+  QList<QByteArray> identities(void) const;
+  bool contains(const QByteArray &identity) const;
+  bool insert(const QByteArray &identity, const quint64 time);
+  int capacity(void) const;
+  int size(void) const;
+  quint64 evictions(void) const;
+  quint64 time(const QByteArray &identity) const;
+  void clear(void);
+  void remove(const QByteArray &identity);
+  void set_capacity(const int capacity);
+
+ private:
+  QVector<char> m_keys;
+  QVector<int> m_index; // Slot + 1.
+  QVector<int> m_free;
+  QVector<quint64> m_times;
+  QVector<quint8> m_states;
+  QVector<uint> m_hashes;
+  int m_hand;
+  int m_size;
+  quint64 m_evictions;
+  int find(const QByteArray &identity, const uint hash) const;
+  void erase(int position);
+};
+
+#endif
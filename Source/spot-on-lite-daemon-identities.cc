@@ -0,0 +1,409 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+extern "C"
+{
+#include <openssl/rand.h>
+#include <string.h>
+#include <time.h>
+}
+
+#include <QAtomicInteger>
+
+#include "spot-on-lite-daemon-identities.h"
+#include "spot-on-lite-daemon-siphash.h"
+
+/*
+** An open-addressing table of remote identities which is shared by
+** the daemon and its children. Each entry holds a 64-byte identity,
+** the time at which it was last seen and the time at which it was last
+** shared through the hub. Times are seconds relative to the creation
+** of the table.
+**
+** A child publishes every identity which its peer announces. The child
+** shares the identity with the other children only if no child has
+** shared it within the share interval, which the daemon derives from
+** the shortest identities lifetime. A child whose peer joins later
+** reads the current identities from the table and sends them to the
+** peer directly rather than through the hub. Children claim entries
+** with compare-and-swap. Concurrent publications of a new identity may
+** claim two entries, in which case the identity is shared twice. The
+** table is advisory: a full table admits every share.
+**
+** The home of an identity is derived from a keyed SipHash of the
+** identity since peers choose identities. The daemon expires entries
+** which have not been seen within the lifetime.
+*/
+
+struct spot_on_lite_daemon_identities_header
+{
+  quint64 magic;
+  quint64 epoch; // Monotonic seconds.
+  quint32 capacity;
+  quint32 version;
+  QBasicAtomicInteger<quint32> lifetime;
+  QBasicAtomicInteger<quint32> share_interval;
+  char key[spot_on_lite_daemon_siphash::KEY_SIZE];
+  char reserved[16];
+};
+
+struct spot_on_lite_daemon_identities_entry
+{
+  char identity[spot_on_lite_daemon_identities::IDENTITY_SIZE];
+  QBasicAtomicInteger<quint32> last_seen;
+  QBasicAtomicInteger<quint32> last_shared;
+  QBasicAtomicInteger<quint32> state;
+  char reserved[52];
+};
+
+static_assert(sizeof(spot_on_lite_daemon_identities_header) == 64,
+	      "Irregular identities header.");
+static_assert(sizeof(spot_on_lite_daemon_identities_entry) == 128,
+	      "Irregular identities entry.");
+
+static const int MAXIMUM_PROBES = 64;
+static const int MAXIMUM_RETRIES = 4;
+static const quint32 BUSY = 2;
+static const quint32 EMPTY = 0;
+static const quint32 READY = 3;
+static const quint32 TOMBSTONE = 1;
+static quint64 s_magic = 0x53504f544944454eULL; // SPOTIDEN
+static quint32 s_version = 3;
+
+static spot_on_lite_daemon_identities_entry *entries_at
+(const spot_on_lite_daemon_shared_memory &shared_memory)
+{
+  return reinterpret_cast<spot_on_lite_daemon_identities_entry *>
+    (static_cast<char *> (shared_memory.data()) +
+     sizeof(spot_on_lite_daemon_identities_header));
+}
+
+static spot_on_lite_daemon_identities_header *header_at
+(const spot_on_lite_daemon_shared_memory &shared_memory)
+{
+  return static_cast<spot_on_lite_daemon_identities_header *>
+    (shared_memory.data());
+}
+
+static quint64 monotonic_seconds(void)
+{
+  struct timespec ts = {};
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<quint64> (ts.tv_sec);
+}
+
+spot_on_lite_daemon_identities::spot_on_lite_daemon_identities(void)
+{
+}
+
+spot_on_lite_daemon_identities::~spot_on_lite_daemon_identities()
+{
+  detach();
+}
+
+QString spot_on_lite_daemon_identities::file_name
+(const QString &remote_identities_file_name)
+{
+  return remote_identities_file_name + ".shm";
+}
+
+bool spot_on_lite_daemon_identities::attach(const QString &file_name)
+{
+  detach();
+
+  if(!m_shared_memory.attach(file_name, false))
+    return false;
+
+  auto header = header_at(m_shared_memory);
+
+  if(m_shared_memory.size() < sizeof(*header) ||
+     header->magic != s_magic ||
+     header->version != s_version ||
+     header->capacity == 0 ||
+     (header->capacity & (header->capacity - 1)) != 0 ||
+     m_shared_memory.size() < sizeof(*header) +
+     static_cast<size_t> (header->capacity) *
+     sizeof(spot_on_lite_daemon_identities_entry))
+    {
+      m_shared_memory.detach();
+      return false;
+    }
+
+  return true;
+}
+
+bool spot_on_lite_daemon_identities::create
+(const QString &file_name,
+ const int capacity,
+ const int lifetime,
+ const int share_interval)
+{
+  detach();
+
+  char key[spot_on_lite_daemon_siphash::KEY_SIZE];
+
+  if(RAND_bytes(reinterpret_cast<unsigned char *> (key),
+		static_cast<int> (sizeof(key))) != 1)
+    return false;
+
+  /*
+  ** The capacity is rounded up to a power of two.
+  */
+
+  auto c = static_cast<quint32> (MINIMUM_CAPACITY);
+  auto maximum = static_cast<quint32> (MAXIMUM_CAPACITY);
+
+  while(c < maximum && c < static_cast<quint32> (capacity))
+    c <<= 1;
+
+  if(!m_shared_memory.
+     create(file_name,
+	    sizeof(spot_on_lite_daemon_identities_header) +
+	    static_cast<size_t> (c) *
+	    sizeof(spot_on_lite_daemon_identities_entry)))
+    {
+      memset(key, 0, sizeof(key));
+      return false;
+    }
+
+  /*
+  ** The file is zero-filled, which is to say empty.
+  */
+
+  auto header = header_at(m_shared_memory);
+
+  header->capacity = c;
+  header->epoch = monotonic_seconds();
+  header->lifetime.storeRelease(static_cast<quint32> (qMax(1, lifetime)));
+  header->share_interval.storeRelease
+    (static_cast<quint32> (qMax(0, share_interval)));
+  memcpy(header->key, key, sizeof(key));
+  memset(key, 0, sizeof(key));
+  header->version = s_version;
+  header->magic = s_magic;
+  return true;
+}
+
+bool spot_on_lite_daemon_identities::is_attached(void) const
+{
+  return m_shared_memory.is_attached();
+}
+
+bool spot_on_lite_daemon_identities::publish(const QByteArray &identity)
+{
+  /*
+  ** Records the identity on behalf of the process. Returns true if the
+  ** process should share the identity.
+  */
+
+  if(!is_attached() || identity.length() != IDENTITY_SIZE)
+    return true;
+
+  auto entries = entries_at(m_shared_memory);
+  auto header = header_at(m_shared_memory);
+  auto lifetime = header->lifetime.loadAcquire();
+  auto mask = static_cast<quint64> (header->capacity - 1);
+  auto n = now();
+  auto share_interval = header->share_interval.loadAcquire();
+  char digest[16];
+  quint64 home = 0;
+
+  spot_on_lite_daemon_siphash::siphash_2_4_128
+    (header->key,
+     identity.constData(),
+     static_cast<size_t> (identity.length()),
+     digest);
+  memcpy(&home, digest, sizeof(home));
+
+  for(int retry = 0; retry < MAXIMUM_RETRIES; retry++)
+    {
+      quint32 expected = EMPTY;
+      qint64 target = -1;
+
+      for(int i = 0; i < MAXIMUM_PROBES; i++)
+	{
+	  auto index = (home + static_cast<quint64> (i)) & mask;
+	  auto &entry(entries[index]);
+	  auto state = entry.state.loadAcquire();
+
+	  if(state == EMPTY)
+	    {
+	      if(target < 0)
+		{
+		  expected = state;
+		  target = static_cast<qint64> (index);
+		}
+
+	      break;
+	    }
+
+	  auto expired = state == TOMBSTONE ||
+	    (state == READY && n - entry.last_seen.loadAcquire() >= lifetime);
+
+	  if(state == READY &&
+	     !expired &&
+	     memcmp(entry.identity, identity.constData(), IDENTITY_SIZE) == 0)
+	    {
+	      entry.last_seen.storeRelease(n);
+
+	      auto shared = entry.last_shared.loadAcquire();
+
+	      while(n - shared >= share_interval)
+		if(entry.last_shared.testAndSetOrdered(shared, n))
+		  return true;
+		else
+		  shared = entry.last_shared.loadAcquire();
+
+	      return false;
+	    }
+
+	  if(expired && target < 0)
+	    {
+	      expected = state;
+	      target = static_cast<qint64> (index);
+	    }
+	}
+
+      if(target < 0)
+	return true; // Full.
+
+      auto &entry(entries[target]);
+
+      if(entry.state.testAndSetOrdered(expected, BUSY))
+	{
+	  memcpy(entry.identity, identity.constData(), IDENTITY_SIZE);
+	  entry.last_seen.storeRelease(n);
+	  entry.last_shared.storeRelease(n);
+	  entry.state.storeRelease(READY);
+	  return true;
+	}
+    }
+
+  return true;
+}
+
+int spot_on_lite_daemon_identities::capacity(void) const
+{
+  if(!is_attached())
+    return 0;
+
+  return static_cast<int> (header_at(m_shared_memory)->capacity);
+}
+
+int spot_on_lite_daemon_identities::purge(void)
+{
+  /*
+  ** Expired entries become tombstones. Tombstones which precede an
+  ** empty entry are emptied. Only the daemon purges.
+  */
+
+  if(!is_attached())
+    return 0;
+
+  auto entries = entries_at(m_shared_memory);
+  auto header = header_at(m_shared_memory);
+  auto lifetime = header->lifetime.loadAcquire();
+  auto mask = static_cast<quint64> (header->capacity - 1);
+  auto n = now();
+  int count = 0;
+
+  for(quint64 i = 0; i <= mask; i++)
+    if(entries[i].state.loadAcquire() == READY &&
+       n - entries[i].last_seen.loadAcquire() >= lifetime &&
+       entries[i].state.testAndSetOrdered(READY, TOMBSTONE))
+      count += 1;
+
+  for(quint64 i = mask + 1; i > 0; i--)
+    {
+      auto index = i - 1;
+
+      if(entries[index].state.loadAcquire() == TOMBSTONE &&
+	 entries[(index + 1) & mask].state.loadAcquire() == EMPTY)
+	entries[index].state.testAndSetOrdered(TOMBSTONE, EMPTY);
+    }
+
+  return count;
+}
+
+QVector<QByteArray> spot_on_lite_daemon_identities::identities(void) const
+{
+  /*
+  ** Unexpired identities. An entry which changes while it is copied
+  ** is skipped.
+  */
+
+  QVector<QByteArray> identities;
+
+  if(!is_attached())
+    return identities;
+
+  auto entries = entries_at(m_shared_memory);
+  auto header = header_at(m_shared_memory);
+  auto lifetime = header->lifetime.loadAcquire();
+  auto mask = static_cast<quint64> (header->capacity - 1);
+  auto n = now();
+
+  for(quint64 i = 0; i <= mask; i++)
+    {
+      auto &entry(entries[i]);
+
+      if(entry.state.loadAcquire() != READY)
+	continue;
+
+      auto last_seen = entry.last_seen.loadAcquire();
+
+      if(n - last_seen >= lifetime)
+	continue;
+
+      QByteArray identity(entry.identity, IDENTITY_SIZE);
+
+      if(entry.state.loadAcquire() == READY &&
+	 entry.last_seen.loadAcquire() == last_seen)
+	identities << identity;
+    }
+
+  return identities;
+}
+
+quint32 spot_on_lite_daemon_identities::now(void) const
+{
+  return static_cast<quint32>
+    (monotonic_seconds() - header_at(m_shared_memory)->epoch);
+}
+
+void spot_on_lite_daemon_identities::detach(void)
+{
+  m_shared_memory.detach();
+}
+
+void spot_on_lite_daemon_identities::set_lifetime(const int lifetime)
+{
+  if(is_attached())
+    header_at(m_shared_memory)->lifetime.storeRelease
+      (static_cast<quint32> (qMax(1, lifetime)));
+}
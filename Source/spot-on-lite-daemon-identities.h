@@ -0,0 +1,63 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _spot_on_lite_daemon_identities_h_
+#define _spot_on_lite_daemon_identities_h_
+
+#include <QByteArray>
+#include <QVector>
+
+#include "spot-on-lite-daemon-shared-memory.h"
+
+class spot_on_lite_daemon_identities
+{
+ public:
+  static const int IDENTITY_SIZE = 64;
+  static const int MAXIMUM_CAPACITY = 1 << 20;
+  static const int MINIMUM_CAPACITY = 1 << 10;
+  spot_on_lite_daemon_identities(void);
+  ~spot_on_lite_daemon_identities();
+  static QString file_name(const QString &remote_identities_file_name);
+  bool attach(const QString &file_name);
+  bool create(const QString &file_name,
+	      const int capacity,
+	      const int lifetime,
+	      const int share_interval);
+  bool is_attached(void) const;
+  bool publish(const QByteArray &identity);
+  int capacity(void) const;
+  int purge(void);
+  QVector<QByteArray> identities(void) const;
+  void detach(void);
+  void set_lifetime(const int lifetime);
+
+ private:
+  spot_on_lite_daemon_shared_memory m_shared_memory;
+  quint32 now(void) const;
+};
+
+#endif
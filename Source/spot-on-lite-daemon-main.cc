@@ -44,6 +44,8 @@ extern "C"
 
 #include "spot-on-lite-daemon.h"
 #ifdef SPOTON_LITE_DAEMON_SHA_TEST
+#include <QVector>
+
 #include "spot-on-lite-daemon-sha.h"
 #endif
 
@@ -208,6 +210,7 @@ int main(int argc, char *argv[])
 #ifdef SPOTON_LITE_DAEMON_SHA_TEST
   spot_on_lite_daemon_sha s;
 
+  qDebug() << "SHA-512 kernel: " << s.sha_512_kernel() << ".";
   qDebug() << "SHA-512 test 1: "
 	   << (s.sha_512("abc").toHex() ==
 	       "ddaf35a193617abacc417349ae204131"
@@ -222,6 +225,78 @@ int main(int argc, char *argv[])
 	       "8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4"
 	       "331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909")
 	   << ".";
+
+  /*
+  ** One million a's in pieces of every length up to 257 bytes.
+  */
+
+  QByteArray a(257, 'a');
+  char digest[spot_on_lite_daemon_sha::SHA_512_OUTPUT_LENGTH];
+  int length = 1000000;
+  spot_on_lite_daemon_sha::sha_512_context context;
+
+  s.sha_512_init(context);
+
+  for(int i = 1; length > 0; i = i % a.length() + 1)
+    {
+      s.sha_512_update(context, a.constData(), static_cast<size_t> (i));
+      length -= i;
+
+      if(length < a.length())
+	{
+	  s.sha_512_update(context, a.constData(), static_cast<size_t> (length));
+	  length = 0;
+	}
+    }
+
+  s.sha_512_final(context, digest);
+  qDebug() << "SHA-512 test 3: "
+	   << (QByteArray(digest, static_cast<int> (sizeof(digest))).toHex() ==
+	       "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803"
+	       "afa973ebde0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e"
+	       "4eadb217ad8cc09b")
+	   << ".";
+
+  s.sha_512_hmac("what do ya want for nothing?",
+		 s.prepare_hmac_key("Jefe"),
+		 digest);
+  qDebug() << "HMAC-SHA-512 test 1: "
+	   << (QByteArray(digest, static_cast<int> (sizeof(digest))).toHex() ==
+	       "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7"
+	       "ea2505549758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b"
+	       "636e070a38bce737")
+	   << ".";
+
+  /*
+  ** The batch exercises every kernel width. Lane 5 holds the key of
+  ** test 1.
+  */
+
+  QVector<spot_on_lite_daemon_sha::hmac_key> keys;
+  auto ok = true;
+  char digests[13 * spot_on_lite_daemon_sha::SHA_512_OUTPUT_LENGTH];
+
+  for(int i = 0; i < 13; i++)
+    keys << s.prepare_hmac_key
+      (i == 5 ? QByteArray("Jefe") : QByteArray::number(i));
+
+  s.sha_512_hmac
+    ("what do ya want for nothing?", keys.constData(), keys.size(), digests);
+
+  for(int i = 0; i < keys.size(); i++)
+    {
+      s.sha_512_hmac("what do ya want for nothing?", keys.at(i), digest);
+      ok &= memcmp(digest, digests + i * sizeof(digest), sizeof(digest)) == 0;
+    }
+
+  qDebug() << "HMAC-SHA-512 test 2: "
+	   << (ok &&
+	       QByteArray(digests + 5 * sizeof(digest),
+			  static_cast<int> (sizeof(digest))).toHex() ==
+	       "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7"
+	       "ea2505549758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b"
+	       "636e070a38bce737")
+	   << ".";
 #endif
 
   for(int i = 0; i < argc; i++)
@@ -25,7 +25,21 @@
 ** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <QCryptographicHash>
+extern "C"
+{
+#include <string.h>
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__linux__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#endif
+
+#include <iostream>
+
 #include <QtCore>
 #include <QtEndian>
 #include <QtGlobal>
@@ -57,345 +71,1170 @@
 #define s0_512(x) (ROTR(1, x) ^ ROTR(8, x) ^ SHR(7, x))
 #define s1_512(x) (ROTR(19, x) ^ ROTR(61, x) ^ SHR(6, x))
 
-static QByteArray s_sha_512_h[] = {QByteArray::fromHex("6a09e667f3bcc908"),
-				   QByteArray::fromHex("bb67ae8584caa73b"),
-				   QByteArray::fromHex("3c6ef372fe94f82b"),
-				   QByteArray::fromHex("a54ff53a5f1d36f1"),
-				   QByteArray::fromHex("510e527fade682d1"),
-				   QByteArray::fromHex("9b05688c2b3e6c1f"),
-				   QByteArray::fromHex("1f83d9abfb41bd6b"),
-				   QByteArray::fromHex("5be0cd19137e2179")};
-static QByteArray s_sha_512_k[] =
-  {QByteArray::fromHex("428a2f98d728ae22"),
-   QByteArray::fromHex("7137449123ef65cd"),
-   QByteArray::fromHex("b5c0fbcfec4d3b2f"),
-   QByteArray::fromHex("e9b5dba58189dbbc"),
-   QByteArray::fromHex("3956c25bf348b538"),
-   QByteArray::fromHex("59f111f1b605d019"),
-   QByteArray::fromHex("923f82a4af194f9b"),
-   QByteArray::fromHex("ab1c5ed5da6d8118"),
-   QByteArray::fromHex("d807aa98a3030242"),
-   QByteArray::fromHex("12835b0145706fbe"),
-   QByteArray::fromHex("243185be4ee4b28c"),
-   QByteArray::fromHex("550c7dc3d5ffb4e2"),
-   QByteArray::fromHex("72be5d74f27b896f"),
-   QByteArray::fromHex("80deb1fe3b1696b1"),
-   QByteArray::fromHex("9bdc06a725c71235"),
-   QByteArray::fromHex("c19bf174cf692694"),
-   QByteArray::fromHex("e49b69c19ef14ad2"),
-   QByteArray::fromHex("efbe4786384f25e3"),
-   QByteArray::fromHex("0fc19dc68b8cd5b5"),
-   QByteArray::fromHex("240ca1cc77ac9c65"),
-   QByteArray::fromHex("2de92c6f592b0275"),
-   QByteArray::fromHex("4a7484aa6ea6e483"),
-   QByteArray::fromHex("5cb0a9dcbd41fbd4"),
-   QByteArray::fromHex("76f988da831153b5"),
-   QByteArray::fromHex("983e5152ee66dfab"),
-   QByteArray::fromHex("a831c66d2db43210"),
-   QByteArray::fromHex("b00327c898fb213f"),
-   QByteArray::fromHex("bf597fc7beef0ee4"),
-   QByteArray::fromHex("c6e00bf33da88fc2"),
-   QByteArray::fromHex("d5a79147930aa725"),
-   QByteArray::fromHex("06ca6351e003826f"),
-   QByteArray::fromHex("142929670a0e6e70"),
-   QByteArray::fromHex("27b70a8546d22ffc"),
-   QByteArray::fromHex("2e1b21385c26c926"),
-   QByteArray::fromHex("4d2c6dfc5ac42aed"),
-   QByteArray::fromHex("53380d139d95b3df"),
-   QByteArray::fromHex("650a73548baf63de"),
-   QByteArray::fromHex("766a0abb3c77b2a8"),
-   QByteArray::fromHex("81c2c92e47edaee6"),
-   QByteArray::fromHex("92722c851482353b"),
-   QByteArray::fromHex("a2bfe8a14cf10364"),
-   QByteArray::fromHex("a81a664bbc423001"),
-   QByteArray::fromHex("c24b8b70d0f89791"),
-   QByteArray::fromHex("c76c51a30654be30"),
-   QByteArray::fromHex("d192e819d6ef5218"),
-   QByteArray::fromHex("d69906245565a910"),
-   QByteArray::fromHex("f40e35855771202a"),
-   QByteArray::fromHex("106aa07032bbd1b8"),
-   QByteArray::fromHex("19a4c116b8d2d0c8"),
-   QByteArray::fromHex("1e376c085141ab53"),
-   QByteArray::fromHex("2748774cdf8eeb99"),
-   QByteArray::fromHex("34b0bcb5e19b48a8"),
-   QByteArray::fromHex("391c0cb3c5c95a63"),
-   QByteArray::fromHex("4ed8aa4ae3418acb"),
-   QByteArray::fromHex("5b9cca4f7763e373"),
-   QByteArray::fromHex("682e6ff3d6b2b8a3"),
-   QByteArray::fromHex("748f82ee5defb2fc"),
-   QByteArray::fromHex("78a5636f43172f60"),
-   QByteArray::fromHex("84c87814a1f0ab72"),
-   QByteArray::fromHex("8cc702081a6439ec"),
-   QByteArray::fromHex("90befffa23631e28"),
-   QByteArray::fromHex("a4506cebde82bde9"),
-   QByteArray::fromHex("bef9a3f7b2c67915"),
-   QByteArray::fromHex("c67178f2e372532b"),
-   QByteArray::fromHex("ca273eceea26619c"),
-   QByteArray::fromHex("d186b8c721c0c207"),
-   QByteArray::fromHex("eada7dd6cde0eb1e"),
-   QByteArray::fromHex("f57d4f7fee6ed178"),
-   QByteArray::fromHex("06f067aa72176fba"),
-   QByteArray::fromHex("0a637dc5a2c898a6"),
-   QByteArray::fromHex("113f9804bef90dae"),
-   QByteArray::fromHex("1b710b35131c471b"),
-   QByteArray::fromHex("28db77f523047d84"),
-   QByteArray::fromHex("32caab7b40c72493"),
-   QByteArray::fromHex("3c9ebe0a15c9bebc"),
-   QByteArray::fromHex("431d67c49c100d4c"),
-   QByteArray::fromHex("4cc5d4becb3e42b6"),
-   QByteArray::fromHex("597f299cfc657e2a"),
-   QByteArray::fromHex("5fcb6fab3ad6faec"),
-   QByteArray::fromHex("6c44198c4a475817")};
+static constexpr quint64 s_sha_512_h[] =
+  {Q_UINT64_C(0x6a09e667f3bcc908), Q_UINT64_C(0xbb67ae8584caa73b),
+   Q_UINT64_C(0x3c6ef372fe94f82b), Q_UINT64_C(0xa54ff53a5f1d36f1),
+   Q_UINT64_C(0x510e527fade682d1), Q_UINT64_C(0x9b05688c2b3e6c1f),
+   Q_UINT64_C(0x1f83d9abfb41bd6b), Q_UINT64_C(0x5be0cd19137e2179)};
+static constexpr quint64 s_sha_512_k[] =
+  {Q_UINT64_C(0x428a2f98d728ae22), Q_UINT64_C(0x7137449123ef65cd),
+   Q_UINT64_C(0xb5c0fbcfec4d3b2f), Q_UINT64_C(0xe9b5dba58189dbbc),
+   Q_UINT64_C(0x3956c25bf348b538), Q_UINT64_C(0x59f111f1b605d019),
+   Q_UINT64_C(0x923f82a4af194f9b), Q_UINT64_C(0xab1c5ed5da6d8118),
+   Q_UINT64_C(0xd807aa98a3030242), Q_UINT64_C(0x12835b0145706fbe),
+   Q_UINT64_C(0x243185be4ee4b28c), Q_UINT64_C(0x550c7dc3d5ffb4e2),
+   Q_UINT64_C(0x72be5d74f27b896f), Q_UINT64_C(0x80deb1fe3b1696b1),
+   Q_UINT64_C(0x9bdc06a725c71235), Q_UINT64_C(0xc19bf174cf692694),
+   Q_UINT64_C(0xe49b69c19ef14ad2), Q_UINT64_C(0xefbe4786384f25e3),
+   Q_UINT64_C(0x0fc19dc68b8cd5b5), Q_UINT64_C(0x240ca1cc77ac9c65),
+   Q_UINT64_C(0x2de92c6f592b0275), Q_UINT64_C(0x4a7484aa6ea6e483),
+   Q_UINT64_C(0x5cb0a9dcbd41fbd4), Q_UINT64_C(0x76f988da831153b5),
+   Q_UINT64_C(0x983e5152ee66dfab), Q_UINT64_C(0xa831c66d2db43210),
+   Q_UINT64_C(0xb00327c898fb213f), Q_UINT64_C(0xbf597fc7beef0ee4),
+   Q_UINT64_C(0xc6e00bf33da88fc2), Q_UINT64_C(0xd5a79147930aa725),
+   Q_UINT64_C(0x06ca6351e003826f), Q_UINT64_C(0x142929670a0e6e70),
+   Q_UINT64_C(0x27b70a8546d22ffc), Q_UINT64_C(0x2e1b21385c26c926),
+   Q_UINT64_C(0x4d2c6dfc5ac42aed), Q_UINT64_C(0x53380d139d95b3df),
+   Q_UINT64_C(0x650a73548baf63de), Q_UINT64_C(0x766a0abb3c77b2a8),
+   Q_UINT64_C(0x81c2c92e47edaee6), Q_UINT64_C(0x92722c851482353b),
+   Q_UINT64_C(0xa2bfe8a14cf10364), Q_UINT64_C(0xa81a664bbc423001),
+   Q_UINT64_C(0xc24b8b70d0f89791), Q_UINT64_C(0xc76c51a30654be30),
+   Q_UINT64_C(0xd192e819d6ef5218), Q_UINT64_C(0xd69906245565a910),
+   Q_UINT64_C(0xf40e35855771202a), Q_UINT64_C(0x106aa07032bbd1b8),
+   Q_UINT64_C(0x19a4c116b8d2d0c8), Q_UINT64_C(0x1e376c085141ab53),
+   Q_UINT64_C(0x2748774cdf8eeb99), Q_UINT64_C(0x34b0bcb5e19b48a8),
+   Q_UINT64_C(0x391c0cb3c5c95a63), Q_UINT64_C(0x4ed8aa4ae3418acb),
+   Q_UINT64_C(0x5b9cca4f7763e373), Q_UINT64_C(0x682e6ff3d6b2b8a3),
+   Q_UINT64_C(0x748f82ee5defb2fc), Q_UINT64_C(0x78a5636f43172f60),
+   Q_UINT64_C(0x84c87814a1f0ab72), Q_UINT64_C(0x8cc702081a6439ec),
+   Q_UINT64_C(0x90befffa23631e28), Q_UINT64_C(0xa4506cebde82bde9),
+   Q_UINT64_C(0xbef9a3f7b2c67915), Q_UINT64_C(0xc67178f2e372532b),
+   Q_UINT64_C(0xca273eceea26619c), Q_UINT64_C(0xd186b8c721c0c207),
+   Q_UINT64_C(0xeada7dd6cde0eb1e), Q_UINT64_C(0xf57d4f7fee6ed178),
+   Q_UINT64_C(0x06f067aa72176fba), Q_UINT64_C(0x0a637dc5a2c898a6),
+   Q_UINT64_C(0x113f9804bef90dae), Q_UINT64_C(0x1b710b35131c471b),
+   Q_UINT64_C(0x28db77f523047d84), Q_UINT64_C(0x32caab7b40c72493),
+   Q_UINT64_C(0x3c9ebe0a15c9bebc), Q_UINT64_C(0x431d67c49c100d4c),
+   Q_UINT64_C(0x4cc5d4becb3e42b6), Q_UINT64_C(0x597f299cfc657e2a),
+   Q_UINT64_C(0x5fcb6fab3ad6faec), Q_UINT64_C(0x6c44198c4a475817)};
 static int s_block_length = 1024 / CHAR_BIT;
 
-spot_on_lite_daemon_sha::spot_on_lite_daemon_sha(void)
+static void sha_512_block(quint64 *H, const uchar *block)
 {
+  /*
+  ** Computing the hash (6.4.2) of a single block.
+  */
+
+  auto K = s_sha_512_k;
+  quint64 W[80];
+
+  for(int t = 0; t <= 15; t++)
+    W[t] = qFromBigEndian<quint64> (block + 8 * t);
+
+  for(int t = 16; t <= 79; t++)
+    W[t] = s1_512(W[t - 2]) + W[t - 7] + s0_512(W[t - 15]) + W[t - 16];
+
+  auto a = H[0];
+  auto b = H[1];
+  auto c = H[2];
+  auto d = H[3];
+  auto e = H[4];
+  auto f = H[5];
+  auto g = H[6];
+  auto h = H[7];
+
+  for(int t = 0; t <= 79; t++)
+    {
+      auto T1 = h + S1_512(e) + Ch(e, f, g) + K[t] + W[t];
+      auto T2 = S0_512(a) + Maj(a, b, c);
+
+      h = g;
+      g = f;
+      f = e;
+      e = d + T1;
+      d = c;
+      c = b;
+      b = a;
+      a = T1 + T2;
+    }
+
+  H[0] += a;
+  H[1] += b;
+  H[2] += c;
+  H[3] += d;
+  H[4] += e;
+  H[5] += f;
+  H[6] += g;
+  H[7] += h;
 }
 
-QByteArray spot_on_lite_daemon_sha::sha_512(const QByteArray &data) const
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SPOTON_LITE_DAEMON_SHA_512_LANES
+
+/*
+** Several keyed hashes of the same data are computed in the lanes of
+** vector registers. The lanes share the message schedule of the inner
+** hashes. The outer blocks consist of the inner states.
+*/
+
+typedef quint64 sha_512_x4 __attribute__((vector_size(32)));
+typedef quint64 sha_512_x8 __attribute__((vector_size(64)));
+
+template<typename V>
+inline __attribute__((always_inline)) static void sha_512_block_lanes
+(V *H, const V *M)
 {
-#ifdef SPOTON_LITE_DAEMON_CHILD_ECL_SUPPORTED
-  QByteArray hash;
-  auto bytes(QString("(sha_512 '#%1(").arg(data.length()).toLatin1());
+  auto K = s_sha_512_k;
+  V W[80];
+
+  for(int t = 0; t <= 15; t++)
+    W[t] = M[t];
 
-  for(int i = 0; i < data.length(); i++)
+  for(int t = 16; t <= 79; t++)
+    W[t] = s1_512(W[t - 2]) + W[t - 7] + s0_512(W[t - 15]) + W[t - 16];
+
+  auto a = H[0];
+  auto b = H[1];
+  auto c = H[2];
+  auto d = H[3];
+  auto e = H[4];
+  auto f = H[5];
+  auto g = H[6];
+  auto h = H[7];
+
+  for(int t = 0; t <= 79; t++)
     {
-      bytes.append(QByteArray::number(static_cast<unsigned char> (data.at(i))));
-      bytes.append(' ');
+      auto T1 = h + S1_512(e) + Ch(e, f, g) + K[t] + W[t];
+      auto T2 = S0_512(a) + Maj(a, b, c);
+
+      h = g;
+      g = f;
+      f = e;
+      e = d + T1;
+      d = c;
+      c = b;
+      b = a;
+      a = T1 + T2;
     }
 
-  bytes = bytes.mid(0, bytes.length() - 1);
-  bytes.append("))");
-  ecl_import_current_thread(ECL_NIL, ECL_NIL);
+  H[0] += a;
+  H[1] += b;
+  H[2] += c;
+  H[3] += d;
+  H[4] += e;
+  H[5] += f;
+  H[6] += g;
+  H[7] += h;
+}
 
-  auto c = ecl_read_from_cstring(bytes.data()); // constData()?
+template<typename V>
+inline __attribute__((always_inline)) static void sha_512_hmac_lanes
+(const uchar *data,
+ const int length,
+ const spot_on_lite_daemon_sha::hmac_key *keys,
+ char *digests)
+{
+  const int lanes = static_cast<int> (sizeof(V) / sizeof(quint64));
+  int i = 0;
+  uchar block[256];
+  V H[8];
+  V M[16];
 
-  if(c)
-    c = cl_safe_eval(c, Cnil, Cnil);
-  else
-    goto done_label;
+  for(int j = 0; j < 8; j++)
+    for(int k = 0; k < lanes; k++)
+      H[j][k] = keys[k].inner[j];
+
+  for(; length - i >= 128; i += 128)
+    {
+      for(int t = 0; t <= 15; t++)
+	M[t] = V() + qFromBigEndian<quint64> (data + i + 8 * t);
 
-  if(!c)
-    goto done_label;
+      sha_512_block_lanes(H, M);
+    }
+
+  /*
+  ** Padding (5.1.2). The inner message is preceded by a block.
+  */
+
+  auto blocks = length - i >= 112 ? 2 : 1;
+
+  memset(block, 0, sizeof(block));
+  memcpy(block, data + i, static_cast<size_t> (length - i));
+  block[length - i] = 0x80;
+  qToBigEndian(8 * static_cast<quint64> (128 + length),
+	       block + 128 * blocks - 8);
 
-  for(cl_index i = 0; i < 8; i++)
+  for(int j = 0; j < blocks; j++)
     {
-      QByteArray h(8, 0);
-      auto e = ecl_aref(c, i);
+      for(int t = 0; t <= 15; t++)
+	M[t] = V() + qFromBigEndian<quint64> (block + 128 * j + 8 * t);
+
+      sha_512_block_lanes(H, M);
+    }
+
+  for(int t = 0; t <= 7; t++)
+    M[t] = H[t];
+
+  M[8] = V() + (static_cast<quint64> (1) << 63);
+
+  for(int t = 9; t <= 14; t++)
+    M[t] = V();
 
-      if(e)
-	qToBigEndian(static_cast<quint64> (ecl_to_uint64_t(e)),
-		     reinterpret_cast<uchar *> (h.data()));
+  M[15] = V() + static_cast<quint64> (8 * (128 + 64));
 
-      hash.append(h);
+  for(int j = 0; j < 8; j++)
+    for(int k = 0; k < lanes; k++)
+      H[j][k] = keys[k].outer[j];
+
+  sha_512_block_lanes(H, M);
+
+  for(int k = 0; k < lanes; k++)
+    for(int j = 0; j < 8; j++)
+      qToBigEndian(static_cast<quint64> (H[j][k]),
+		   reinterpret_cast<uchar *> (digests + 64 * k + 8 * j));
+}
+
+__attribute__((target("avx2"))) static void sha_512_hmac_x4
+(const uchar *data,
+ const int length,
+ const spot_on_lite_daemon_sha::hmac_key *keys,
+ char *digests)
+{
+  sha_512_hmac_lanes<sha_512_x4> (data, length, keys, digests);
+}
+
+__attribute__((target("avx512f"))) static void sha_512_hmac_x8
+(const uchar *data,
+ const int length,
+ const spot_on_lite_daemon_sha::hmac_key *keys,
+ char *digests)
+{
+  sha_512_hmac_lanes<sha_512_x8> (data, length, keys, digests);
+}
+#endif
+
+/*
+** The blocks of a message are compressed by the fastest kernel which
+** the processor supports and which reproduces the test vectors.
+*/
+
+typedef void (*sha_512_blocks_function)
+(quint64 *H, const uchar *blocks, const size_t count);
+
+struct sha_512_kernel
+{
+  QString description;
+  sha_512_blocks_function blocks;
+};
+
+static void sha_512_blocks_portable(quint64 *H,
+				    const uchar *blocks,
+				    const size_t count)
+{
+  for(size_t i = 0; i < count; i++)
+    sha_512_block(H, blocks + 128 * i);
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ROTR_X4(n, x) _mm256_or_si256(_mm256_srli_epi64(x, n),		\
+				      _mm256_slli_epi64(x, 64 - n))
+#define SHR_X4(n, x) _mm256_srli_epi64(x, n)
+#define s0_512_x4(x) _mm256_xor_si256(_mm256_xor_si256(ROTR_X4(1, x),	\
+						       ROTR_X4(8, x)),	\
+				      SHR_X4(7, x))
+#define s1_512_x4(x) _mm256_xor_si256(_mm256_xor_si256(ROTR_X4(19, x),	\
+						       ROTR_X4(61, x)),	\
+				      SHR_X4(6, x))
+
+__attribute__((target("avx2"))) static __m256i sha_512_load_x4
+(const uchar *low, const uchar *high)
+{
+  /*
+  ** Two big-endian words of each of two blocks.
+  */
+
+  const auto swap = _mm256_setr_epi8
+    (7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+     7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+  return _mm256_shuffle_epi8
+    (_mm256_inserti128_si256
+     (_mm256_castsi128_si256
+      (_mm_loadu_si128(reinterpret_cast<const __m128i *> (low))),
+      _mm_loadu_si128(reinterpret_cast<const __m128i *> (high)),
+      1),
+     swap);
+}
+
+static void sha_512_rounds(quint64 *H, const quint64 *WK)
+{
+  /*
+  ** The words of the message schedule include the constants.
+  */
+
+  auto a = H[0];
+  auto b = H[1];
+  auto c = H[2];
+  auto d = H[3];
+  auto e = H[4];
+  auto f = H[5];
+  auto g = H[6];
+  auto h = H[7];
+
+  for(int t = 0; t <= 79; t++)
+    {
+      auto T1 = h + S1_512(e) + Ch(e, f, g) + WK[t];
+      auto T2 = S0_512(a) + Maj(a, b, c);
+
+      h = g;
+      g = f;
+      f = e;
+      e = d + T1;
+      d = c;
+      c = b;
+      b = a;
+      a = T1 + T2;
     }
 
- done_label:
-  ecl_release_current_thread();
-  return hash;
-#else
-  return QCryptographicHash::hash(data, QCryptographicHash::Sha512);
+  H[0] += a;
+  H[1] += b;
+  H[2] += c;
+  H[3] += d;
+  H[4] += e;
+  H[5] += f;
+  H[6] += g;
+  H[7] += h;
+}
 
-  if(m_K.isEmpty())
+__attribute__((target("avx2"))) static void sha_512_blocks_avx2
+(quint64 *H, const uchar *blocks, const size_t count)
+{
+  /*
+  ** The message schedules of two blocks are computed in the halves of
+  ** the registers, two words at a time. X[t] holds the words 2t and
+  ** 2t + 1 of both blocks. A single block is left to the portable
+  ** kernel.
+  */
+
+  __m256i X[40];
+  quint64 WK[2][80];
+  size_t i = 0;
+
+  for(; count - i >= 2; i += 2)
     {
-      m_K.resize(80);
+      auto high = blocks + 128 * (i + 1);
+      auto low = blocks + 128 * i;
+
+      for(int t = 0; t <= 7; t++)
+	X[t] = sha_512_load_x4(low + 16 * t, high + 16 * t);
 
-      for(size_t i = 0; i <= 79; i++)
-	m_K[static_cast<int> (i)] = qFromBigEndian<quint64>
-	  (reinterpret_cast<const uchar *> (s_sha_512_k[i].constData()));
+      for(int t = 8; t <= 39; t++)
+	{
+	  auto W15 = _mm256_alignr_epi8(X[t - 7], X[t - 8], 8);
+	  auto W7 = _mm256_alignr_epi8(X[t - 3], X[t - 4], 8);
+
+	  X[t] = _mm256_add_epi64
+	    (_mm256_add_epi64(s1_512_x4(X[t - 1]), W7),
+	     _mm256_add_epi64(s0_512_x4(W15), X[t - 8]));
+	}
+
+      for(int t = 0; t <= 39; t++)
+	{
+	  auto K = _mm256_broadcastsi128_si256
+	    (_mm_loadu_si128
+	     (reinterpret_cast<const __m128i *> (s_sha_512_k + 2 * t)));
+	  auto W = _mm256_add_epi64(X[t], K);
+
+	  _mm_storeu_si128(reinterpret_cast<__m128i *> (WK[0] + 2 * t),
+			   _mm256_castsi256_si128(W));
+	  _mm_storeu_si128(reinterpret_cast<__m128i *> (WK[1] + 2 * t),
+			   _mm256_extracti128_si256(W, 1));
+	}
+
+      sha_512_rounds(H, WK[0]);
+      sha_512_rounds(H, WK[1]);
     }
 
+  if(count > i)
+    sha_512_block(H, blocks + 128 * i);
+}
+
+static bool sha_512_avx2_supported(void)
+{
+  return __builtin_cpu_supports("avx2");
+}
+
+#if (defined(__clang__) && __clang_major__ >= 18) ||	\
+  (!defined(__clang__) && __GNUC__ >= 14)
+#define SPOTON_LITE_DAEMON_SHA_512_X86_EXTENSIONS
+
+__attribute__((target("avx2,sha512"))) static void sha_512_blocks_x86
+(quint64 *H, const uchar *blocks, const size_t count)
+{
   /*
-  ** Please read the NIST.FIPS.180-4.pdf publication.
+  ** The SHA512 extensions. The state is kept as ABEF and CDGH. Each
+  ** VSHA512RNDS2 computes two rounds.
   */
 
-  QByteArray hash;
-  QByteArray number(8, 0);
-  QVector<quint64> H(8);
-  auto N = qCeil(static_cast<double> (data.size() + 17) / 128.0);
+  const auto swap = _mm256_setr_epi8
+    (7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+     7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+  auto abef = _mm256_set_epi64x(static_cast<long long> (H[0]),
+				static_cast<long long> (H[1]),
+				static_cast<long long> (H[4]),
+				static_cast<long long> (H[5]));
+  auto cdgh = _mm256_set_epi64x(static_cast<long long> (H[2]),
+				static_cast<long long> (H[3]),
+				static_cast<long long> (H[6]),
+				static_cast<long long> (H[7]));
+  quint64 state[8];
+  __m256i M[4];
+
+  for(size_t i = 0; i < count; i++)
+    {
+      auto abef_save = abef;
+      auto cdgh_save = cdgh;
+
+      for(int t = 0; t <= 3; t++)
+	M[t] = _mm256_shuffle_epi8
+	  (_mm256_loadu_si256
+	   (reinterpret_cast<const __m256i *> (blocks + 128 * i + 32 * t)),
+	   swap);
+
+      for(int t = 0; t <= 19; t++)
+	{
+	  auto W = _mm256_add_epi64
+	    (M[t % 4],
+	     _mm256_loadu_si256
+	     (reinterpret_cast<const __m256i *> (s_sha_512_k + 4 * t)));
+	  auto x = _mm256_sha512rnds2_epi64
+	    (cdgh, abef, _mm256_castsi256_si128(W));
+
+	  cdgh = abef;
+	  abef = x;
+	  x = _mm256_sha512rnds2_epi64
+	    (cdgh, abef, _mm256_extracti128_si256(W, 1));
+	  cdgh = abef;
+	  abef = x;
+
+	  if(t <= 15)
+	    {
+	      /*
+	      ** The words 4t + 16 to 4t + 19.
+	      */
 
+	      auto W7 = _mm256_blend_epi32
+		(_mm256_permute4x64_epi64(M[(t + 2) % 4], 0x39),
+		 _mm256_permute4x64_epi64(M[(t + 3) % 4], 0x39),
+		 0xc0);
+
+	      x = _mm256_sha512msg1_epi64
+		(M[t % 4], _mm256_castsi256_si128(M[(t + 1) % 4]));
+	      M[t % 4] = _mm256_sha512msg2_epi64
+		(_mm256_add_epi64(x, W7), M[(t + 3) % 4]);
+	    }
+	}
+
+      abef = _mm256_add_epi64(abef, abef_save);
+      cdgh = _mm256_add_epi64(cdgh, cdgh_save);
+    }
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i *> (state), abef);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *> (state + 4), cdgh);
+  H[0] = state[3];
+  H[1] = state[2];
+  H[2] = state[7];
+  H[3] = state[6];
+  H[4] = state[1];
+  H[5] = state[0];
+  H[6] = state[5];
+  H[7] = state[4];
+}
+
+static bool sha_512_x86_supported(void)
+{
+  unsigned int a = 0;
+  unsigned int b = 0;
+  unsigned int c = 0;
+  unsigned int d = 0;
+
+  if(!__builtin_cpu_supports("avx2"))
+    return false;
+
+  if(__get_cpuid_count(7, 1, &a, &b, &c, &d) == 0)
+    return false;
+
+  return (a & 1) != 0; // SHA512
+}
+#endif
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__linux__) && \
+  (defined(__ARM_FEATURE_SHA512) ||					\
+   (defined(__clang__) && __clang_major__ >= 16) ||			\
+   (!defined(__clang__) && __GNUC__ >= 8))
+#define SPOTON_LITE_DAEMON_SHA_512_ARMV8_EXTENSIONS
+#ifndef HWCAP_SHA512
+#define HWCAP_SHA512 (1 << 21)
+#endif
+#ifdef __clang__
+#define SPOTON_LITE_DAEMON_SHA_512_ARMV8_TARGET "sha3"
+#else
+#define SPOTON_LITE_DAEMON_SHA_512_ARMV8_TARGET "+sha3"
+#endif
+
+__attribute__((target(SPOTON_LITE_DAEMON_SHA_512_ARMV8_TARGET)))
+static void sha_512_blocks_armv8(quint64 *H,
+				 const uchar *blocks,
+				 const size_t count)
+{
   /*
-  ** Padding the hash (5.1.2).
+  ** The ARMv8.2 SHA512 instructions. The state is kept as the pairs
+  ** AB, CD, EF and GH whose roles rotate after every two rounds.
   */
 
-  qToBigEndian(static_cast<quint64> (8 * data.length()),
-	       reinterpret_cast<uchar *> (number.data()));
-  hash = QByteArray(128 * N, 0);
-  hash.replace(0, data.length(), data);
-  hash.replace(data.length(), 1, QByteArray::fromHex("80"));
-  hash.replace(hash.length() - number.length(), number.length(), number);
+  auto ab = vld1q_u64(H);
+  auto cd = vld1q_u64(H + 2);
+  auto ef = vld1q_u64(H + 4);
+  auto gh = vld1q_u64(H + 6);
+  uint64x2_t M[8];
+
+  for(size_t i = 0; i < count; i++)
+    {
+      auto a = ab;
+      auto c = cd;
+      auto e = ef;
+      auto g = gh;
+
+      for(int t = 0; t <= 7; t++)
+	M[t] = vreinterpretq_u64_u8
+	  (vrev64q_u8(vld1q_u8(blocks + 128 * i + 16 * t)));
+
+      for(int t = 0; t <= 39; t++)
+	{
+	  auto W = vaddq_u64(M[t % 8], vld1q_u64(s_sha_512_k + 2 * t));
+	  auto fg = vextq_u64(e, g, 1);
+	  auto de = vextq_u64(c, e, 1);
+
+	  W = vextq_u64(W, W, 1);
+
+	  if(t <= 31)
+	    M[t % 8] = vsha512su1q_u64
+	      (vsha512su0q_u64(M[t % 8], M[(t + 1) % 8]),
+	       M[(t + 7) % 8],
+	       vextq_u64(M[(t + 4) % 8], M[(t + 5) % 8], 1));
+
+	  auto x = vsha512hq_u64(vaddq_u64(g, W), fg, de);
+	  auto y = vaddq_u64(c, x);
+
+	  g = e;
+	  e = y;
+	  y = vsha512h2q_u64(x, c, a);
+	  c = a;
+	  a = y;
+	}
+
+      ab = vaddq_u64(ab, a);
+      cd = vaddq_u64(cd, c);
+      ef = vaddq_u64(ef, e);
+      gh = vaddq_u64(gh, g);
+    }
+
+  vst1q_u64(H, ab);
+  vst1q_u64(H + 2, cd);
+  vst1q_u64(H + 4, ef);
+  vst1q_u64(H + 6, gh);
+}
+
+static bool sha_512_armv8_supported(void)
+{
+  return (getauxval(AT_HWCAP) & HWCAP_SHA512) != 0;
+}
+#endif
+
+static void sha_512_digest(const sha_512_blocks_function blocks,
+			   const QByteArray &data,
+			   uchar *digest)
+{
+  auto bytes = reinterpret_cast<const uchar *> (data.constData());
+  auto length = static_cast<size_t> (data.length());
+  quint64 H[8];
+  uchar block[256];
+
+  memcpy(H, s_sha_512_h, sizeof(H));
+  blocks(H, bytes, length / 128);
 
+  auto remainder = length % 128;
+  size_t tail = remainder >= 112 ? 2 : 1;
+
+  memset(block, 0, sizeof(block));
+  memcpy(block, bytes + length - remainder, remainder);
+  block[remainder] = 0x80;
+  qToBigEndian(8 * static_cast<quint64> (length), block + 128 * tail - 8);
+  blocks(H, block, tail);
+
+  for(int i = 0; i < 8; i++)
+    qToBigEndian(H[i], digest + 8 * i);
+}
+
+static bool sha_512_kernel_test(const sha_512_blocks_function blocks)
+{
   /*
-  ** Initializing H (5.3.5).
+  ** The test vectors of spot-on-lite-daemon-main.cc. A message of
+  ** several blocks of each length class is compared against the
+  ** portable kernel, which must also pass the vectors.
   */
 
-  H[0] = qFromBigEndian<quint64>
-    (reinterpret_cast<const uchar *> (s_sha_512_h[0].constData()));
-  H[1] = qFromBigEndian<quint64>
-    (reinterpret_cast<const uchar *> (s_sha_512_h[1].constData()));
-  H[2] = qFromBigEndian<quint64>
-    (reinterpret_cast<const uchar *> (s_sha_512_h[2].constData()));
-  H[3] = qFromBigEndian<quint64>
-    (reinterpret_cast<const uchar *> (s_sha_512_h[3].constData()));
-  H[4] = qFromBigEndian<quint64>
-    (reinterpret_cast<const uchar *> (s_sha_512_h[4].constData()));
-  H[5] = qFromBigEndian<quint64>
-    (reinterpret_cast<const uchar *> (s_sha_512_h[5].constData()));
-  H[6] = qFromBigEndian<quint64>
-    (reinterpret_cast<const uchar *> (s_sha_512_h[6].constData()));
-  H[7] = qFromBigEndian<quint64>
-    (reinterpret_cast<const uchar *> (s_sha_512_h[7].constData()));
+  QByteArray data;
+  uchar digest[64];
+  uchar expected[64];
+
+  sha_512_digest(blocks, "abc", digest);
+
+  if(QByteArray(reinterpret_cast<const char *> (digest), 64).toHex() !=
+     "ddaf35a193617abacc417349ae204131"
+     "12e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a8"
+     "36ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f")
+    return false;
+
+  sha_512_digest(blocks,
+		 "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmg"
+		 "hijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmn"
+		 "opqrstnopqrstu",
+		 digest);
+
+  if(QByteArray(reinterpret_cast<const char *> (digest), 64).toHex() !=
+     "8e959b75dae313da8cf4f72814fc143f"
+     "8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4"
+     "331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909")
+    return false;
+
+  for(int i = 0; i < 1200; i++)
+    data.append(static_cast<char> (i * 31 + 7));
+
+  for(int i = 0; i < data.length(); i += 61)
+    {
+      sha_512_digest(blocks, data.mid(0, i), digest);
+      sha_512_digest(sha_512_blocks_portable, data.mid(0, i), expected);
+
+      if(memcmp(digest, expected, sizeof(digest)) != 0)
+	return false;
+    }
+
+  return true;
+}
+
+static sha_512_kernel select_sha_512_kernel(void)
+{
+  QStringList failures;
+  sha_512_kernel kernel;
+
+  kernel.blocks = nullptr;
+
+#ifdef SPOTON_LITE_DAEMON_SHA_512_X86_EXTENSIONS
+  if(!kernel.blocks && sha_512_x86_supported())
+    {
+      if(sha_512_kernel_test(sha_512_blocks_x86))
+	{
+	  kernel.blocks = sha_512_blocks_x86;
+	  kernel.description = "x86-sha512";
+	}
+      else
+	failures << "x86-sha512";
+    }
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+  if(!kernel.blocks && sha_512_avx2_supported())
+    {
+      if(sha_512_kernel_test(sha_512_blocks_avx2))
+	{
+	  kernel.blocks = sha_512_blocks_avx2;
+	  kernel.description = "avx2";
+	}
+      else
+	failures << "avx2";
+    }
+#endif
+#ifdef SPOTON_LITE_DAEMON_SHA_512_ARMV8_EXTENSIONS
+  if(!kernel.blocks && sha_512_armv8_supported())
+    {
+      if(sha_512_kernel_test(sha_512_blocks_armv8))
+	{
+	  kernel.blocks = sha_512_blocks_armv8;
+	  kernel.description = "armv8-sha512";
+	}
+      else
+	failures << "armv8-sha512";
+    }
+#endif
+
+  if(!kernel.blocks)
+    {
+      kernel.blocks = sha_512_blocks_portable;
+      kernel.description = "portable";
+
+      if(!sha_512_kernel_test(sha_512_blocks_portable))
+	failures << "portable";
+    }
+
+  if(!failures.isEmpty())
+    kernel.description.append
+      (QString(" (failed the test vectors: %1)").arg(failures.join(", ")));
+
+  return kernel;
+}
+
+static const sha_512_kernel &selected_sha_512_kernel(void)
+{
+  static const auto kernel = select_sha_512_kernel();
+
+  return kernel;
+}
+
+#ifdef SPOTON_LITE_DAEMON_SHA_512_LANES
+/*
+** Keyed hashes are computed in the widest lanes which the processor
+** supports and which reproduce the scalar HMAC.
+*/
 
+struct sha_512_lanes
+{
+  QString description;
+  int width;
+};
+
+static bool sha_512_lanes_test(const int width)
+{
   /*
-  ** Computing the hash (6.4.2).
+  ** RFC 4231, test case 2, in the first lane. The other lanes hold
+  ** distinct keys. Messages of each padding class are compared
+  ** against the scalar HMAC.
   */
 
-  for(int i = 0; i < N; i++)
+  QByteArray data("what do ya want for nothing?");
+  char digests[8 * spot_on_lite_daemon_sha::SHA_512_OUTPUT_LENGTH];
+  char expected[spot_on_lite_daemon_sha::SHA_512_OUTPUT_LENGTH];
+  const int lengths[] = {0, 1, 111, 112, 127, 128, 239, 240, 300};
+  spot_on_lite_daemon_sha sha;
+  spot_on_lite_daemon_sha::hmac_key keys[8];
+
+  keys[0] = sha.prepare_hmac_key("Jefe");
+
+  for(int i = 1; i < width; i++)
+    keys[i] = sha.prepare_hmac_key
+      (QByteArray(16 * i, static_cast<char> (0x0b * i)));
+
+  if(width == 8)
+    sha_512_hmac_x8(reinterpret_cast<const uchar *> (data.constData()),
+		    data.length(),
+		    keys,
+		    digests);
+  else
+    sha_512_hmac_x4(reinterpret_cast<const uchar *> (data.constData()),
+		    data.length(),
+		    keys,
+		    digests);
+
+  if(QByteArray(digests, spot_on_lite_daemon_sha::SHA_512_OUTPUT_LENGTH).
+     toHex() !=
+     "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea250554"
+     "9758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737")
+    return false;
+
+  for(size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
     {
-      QVector<quint64> M(16);
-
-      M[0] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 0, 8).
-					  constData()));
-      M[1] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 8, 8).
-					  constData()));
-      M[2] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 16, 8).
-					  constData()));
-      M[3] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 24, 8).
-					  constData()));
-      M[4] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 32, 8).
-					  constData()));
-      M[5] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 40, 8).
-					  constData()));
-      M[6] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 48, 8).
-					  constData()));
-      M[7] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 56, 8).
-					  constData()));
-      M[8] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 64, 8).
-					  constData()));
-      M[9] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 72, 8).
-					  constData()));
-      M[10] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 80, 8).
-					  constData()));
-      M[11] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 88, 8).
-					  constData()));
-      M[12] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 96, 8).
-					  constData()));
-      M[13] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 104, 8).
-					  constData()));
-      M[14] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 112, 8).
-					  constData()));
-      M[15] = qFromBigEndian<quint64>
-	(reinterpret_cast<const uchar *> (hash.mid(128 * i + 120, 8).
-					  constData()));
-
-      auto W(M);
-
-      for(int t = 16; t <= 79; t++)
-	W << (s1_512(W.at(t - 2)) +
-	      W.at(t - 7) +
-	      s0_512(W.at(t - 15)) +
-	      W.at(t - 16));
-
-      auto a = H.at(0);
-      auto b = H.at(1);
-      auto c = H.at(2);
-      auto d = H.at(3);
-      auto e = H.at(4);
-      auto f = H.at(5);
-      auto g = H.at(6);
-      auto h = H.at(7);
-
-      for(int t = 0; t <= 79; t++)
+      data.clear();
+
+      for(int j = 0; j < lengths[i]; j++)
+	data.append(static_cast<char> (j * 31 + 7));
+
+      if(width == 8)
+	sha_512_hmac_x8(reinterpret_cast<const uchar *> (data.constData()),
+			data.length(),
+			keys,
+			digests);
+      else
+	sha_512_hmac_x4(reinterpret_cast<const uchar *> (data.constData()),
+			data.length(),
+			keys,
+			digests);
+
+      for(int j = 0; j < width; j++)
 	{
-	  auto T1 = h + S1_512(e) + Ch(e, f, g) + m_K.at(t) + W.at(t);
-	  auto T2 = S0_512(a) + Maj(a, b, c);
-
-	  h = g;
-	  g = f;
-	  f = e;
-	  e = d + T1;
-	  d = c;
-	  c = b;
-	  b = a;
-	  a = T1 + T2;
+	  sha.sha_512_hmac(data, keys[j], expected);
+
+	  if(memcmp(digests + spot_on_lite_daemon_sha::SHA_512_OUTPUT_LENGTH * j,
+		    expected,
+		    sizeof(expected)) != 0)
+	    return false;
 	}
+    }
 
-      H.replace(0, H.at(0) + a);
-      H.replace(1, H.at(1) + b);
-      H.replace(2, H.at(2) + c);
-      H.replace(3, H.at(3) + d);
-      H.replace(4, H.at(4) + e);
-      H.replace(5, H.at(5) + f);
-      H.replace(6, H.at(6) + g);
-      H.replace(7, H.at(7) + h);
+  return true;
+}
+
+static sha_512_lanes select_sha_512_lanes(void)
+{
+  QStringList failures;
+  sha_512_lanes lanes;
+
+  lanes.width = 1;
+
+  if(__builtin_cpu_supports("avx512f"))
+    {
+      if(sha_512_lanes_test(8))
+	lanes.width = 8;
+      else
+	failures << "x8";
     }
 
-  hash.clear();
-
-  QByteArray h(8, 0);
-
-  qToBigEndian(H.at(0), reinterpret_cast<uchar *> (h.data()));
-  hash.append(h);
-  qToBigEndian(H.at(1), reinterpret_cast<uchar *> (h.data()));
-  hash.append(h);
-  qToBigEndian(H.at(2), reinterpret_cast<uchar *> (h.data()));
-  hash.append(h);
-  qToBigEndian(H.at(3), reinterpret_cast<uchar *> (h.data()));
-  hash.append(h);
-  qToBigEndian(H.at(4), reinterpret_cast<uchar *> (h.data()));
-  hash.append(h);
-  qToBigEndian(H.at(5), reinterpret_cast<uchar *> (h.data()));
-  hash.append(h);
-  qToBigEndian(H.at(6), reinterpret_cast<uchar *> (h.data()));
-  hash.append(h);
-  qToBigEndian(H.at(7), reinterpret_cast<uchar *> (h.data()));
-  hash.append(h);
-  return hash;
+  if(lanes.width == 1 && __builtin_cpu_supports("avx2"))
+    {
+      if(sha_512_lanes_test(4))
+	lanes.width = 4;
+      else
+	failures << "x4";
+    }
+
+  lanes.description = QString("%1 HMAC lane(s)").arg(lanes.width);
+
+  if(!failures.isEmpty())
+    lanes.description.append
+      (QString(" (failed the test vectors: %1)").arg(failures.join(", ")));
+
+  return lanes;
+}
+
+static const sha_512_lanes &selected_sha_512_lanes(void)
+{
+  static const auto lanes = select_sha_512_lanes();
+
+  return lanes;
+}
+#endif
+
+#ifdef SPOTON_LITE_DAEMON_CHILD_ECL_SUPPORTED
+class spot_on_lite_daemon_sha_ecl_thread
+{
+ public:
+  spot_on_lite_daemon_sha_ecl_thread(void)
+  {
+    m_imported = ecl_import_current_thread(ECL_NIL, ECL_NIL);
+  }
+
+  ~spot_on_lite_daemon_sha_ecl_thread()
+  {
+    if(m_imported)
+      ecl_release_current_thread();
+  }
+
+ private:
+  bool m_imported;
+};
+
+static QAtomicInteger<int> s_ecl_failed = 0;
+
+static cl_object byte_vector(const QByteArray &data)
+{
+  /*
+  ** A simple (unsigned-byte 8) vector which holds a copy of data. The
+  ** vector is built by ECL's public constructor since the layout of
+  ** its objects may change.
+  */
+
+  auto length = static_cast<cl_index> (data.length());
+  auto vector = ecl_alloc_simple_vector(length, ecl_aet_b8);
+
+  if(length > 0)
+    memcpy(vector->vector.self.b8, data.constData(), length);
+
+  return vector;
+}
 #endif
+
+spot_on_lite_daemon_sha::spot_on_lite_daemon_sha(void)
+{
+}
+
+QByteArray spot_on_lite_daemon_sha::sha_512(const QByteArray &data) const
+{
+#ifdef SPOTON_LITE_DAEMON_CHILD_ECL_SUPPORTED
+  /*
+  ** The calling thread remains registered with ECL until it exits.
+  */
+
+  static thread_local spot_on_lite_daemon_sha_ecl_thread thread;
+  static auto function = ecl_make_symbol("SHA_512", "COMMON-LISP-USER");
+  auto c = cl_safe_eval
+    (cl_list(2, function, byte_vector(data)), ECL_NIL, ECL_NIL);
+
+  Q_UNUSED(thread);
+
+  if(ecl_t_of(c) == t_vector && ecl_length(c) >= 8)
+    {
+      QByteArray digest(SHA_512_OUTPUT_LENGTH, 0);
+
+      for(cl_index i = 0; i < 8; i++)
+	qToBigEndian
+	  (static_cast<quint64> (ecl_to_uint64_t(ecl_aref(c, i))),
+	   reinterpret_cast<uchar *> (digest.data() + 8 * i));
+
+      return digest;
+    }
+
+  /*
+  ** The evaluation has failed. An empty digest would become the key
+  ** of HMACs, for example. The native engine computes the digest
+  ** instead.
+  */
+
+  if(s_ecl_failed.testAndSetOrdered(0, 1))
+    std::cerr << "spot_on_lite_daemon_sha::sha_512(): "
+	      << "the Lisp SHA-512 has failed. "
+	      << "The native engine will compute failed digests."
+	      << std::endl;
+#endif
+  QByteArray hash(SHA_512_OUTPUT_LENGTH, 0);
+  sha_512_context context;
+
+  sha_512_init(context);
+  sha_512_update
+    (context, data.constData(), static_cast<size_t> (data.length()));
+  sha_512_final(context, hash.data());
+  return hash;
 }
 
 QByteArray spot_on_lite_daemon_sha::sha_512_hmac(const QByteArray &data,
 						 const QByteArray &key) const
+{
+  QByteArray digest(SHA_512_OUTPUT_LENGTH, 0);
+
+  sha_512_hmac(data, prepare_hmac_key(key), digest.data());
+  return digest;
+}
+
+quint64 spot_on_lite_daemon_sha::digest_difference(const char *a,
+						   const char *b)
+{
+  /*
+  ** The bits which differ in two 64-byte digests, folded without
+  ** branches. The lanes are 256 bits wide if AVX2 is enabled and 128
+  ** bits wide otherwise.
+  */
+
+#ifdef __GNUC__
+#ifdef __AVX2__
+  typedef quint64 lanes __attribute__((vector_size(32)));
+#else
+  typedef quint64 lanes __attribute__((vector_size(16)));
+#endif
+  auto rc = lanes();
+  quint64 difference = 0;
+
+  for(size_t i = 0; i < 64; i += sizeof(lanes))
+    {
+      lanes x;
+      lanes y;
+
+      memcpy(&x, a + i, sizeof(x));
+      memcpy(&y, b + i, sizeof(y));
+      rc |= x ^ y;
+    }
+
+  for(size_t i = 0; i < sizeof(lanes) / sizeof(quint64); i++)
+    difference |= rc[i];
+
+  return difference;
+#else
+  quint64 difference = 0;
+
+  for(size_t i = 0; i < 64; i += sizeof(quint64))
+    {
+      quint64 x = 0;
+      quint64 y = 0;
+
+      memcpy(&x, a + i, sizeof(x));
+      memcpy(&y, b + i, sizeof(y));
+      difference |= x ^ y;
+    }
+
+  return difference;
+#endif
+}
+
+spot_on_lite_daemon_sha::hmac_key spot_on_lite_daemon_sha::prepare_hmac_key
+(const QByteArray &key) const
 {
   /*
-  ** Block length is 1024 bits.
-  ** Please read https://en.wikipedia.org/wiki/SHA-2.
+  ** The pads are absorbed once per key. A keyed hash then compresses
+  ** only the message and a single outer block.
   */
 
   auto k(key);
+  hmac_key prepared;
+  uchar block[128];
 
   if(s_block_length < k.length())
     k = sha_512(k);
 
-  if(s_block_length > k.length())
-    k.append(QByteArray(s_block_length - k.length(), 0));
+  for(int i = 0; i < s_block_length; i++)
+    block[i] = static_cast<uchar> ((i < k.length() ? k.at(i) : 0) ^ 0x36);
 
-  QByteArray left(s_block_length, 0);
-  const QByteArray ipad(s_block_length, 0x36);
-  const QByteArray opad(s_block_length, 0x5c);
+  memcpy(prepared.inner, s_sha_512_h, sizeof(prepared.inner));
+  selected_sha_512_kernel().blocks(prepared.inner, block, 1);
 
   for(int i = 0; i < s_block_length; i++)
-    left[i] = static_cast<char> (k.at(i) ^ opad.at(i));
+    block[i] = static_cast<uchar> ((i < k.length() ? k.at(i) : 0) ^ 0x5c);
 
-  QByteArray right(s_block_length, 0);
+  memcpy(prepared.outer, s_sha_512_h, sizeof(prepared.outer));
+  selected_sha_512_kernel().blocks(prepared.outer, block, 1);
+  memset(block, 0, sizeof(block));
+  return prepared;
+}
 
-  for(int i = 0; i < s_block_length; i++)
-    right[i] = static_cast<char> (k.at(i) ^ ipad.at(i));
+void spot_on_lite_daemon_sha::sha_512_hmac(const QByteArray &data,
+					   const hmac_key *keys,
+					   const int count,
+					   char *digests) const
+{
+  /*
+  ** The digests must provide count * SHA_512_OUTPUT_LENGTH bytes.
+  */
+
+  int i = 0;
+
+#ifdef SPOTON_LITE_DAEMON_SHA_512_LANES
+  auto bytes = reinterpret_cast<const uchar *> (data.constData());
+  auto lanes = selected_sha_512_lanes().width;
+
+  if(lanes >= 8)
+    for(; count - i >= 8; i += 8)
+      sha_512_hmac_x8(bytes,
+		      data.length(),
+		      keys + i,
+		      digests + SHA_512_OUTPUT_LENGTH * i);
+
+  if(lanes >= 4)
+    for(; count - i >= 4; i += 4)
+      sha_512_hmac_x4(bytes,
+		      data.length(),
+		      keys + i,
+		      digests + SHA_512_OUTPUT_LENGTH * i);
+#endif
+
+  for(; i < count; i++)
+    sha_512_hmac(data, keys[i], digests + SHA_512_OUTPUT_LENGTH * i);
+}
+
+void spot_on_lite_daemon_sha::sha_512_hmac(const QByteArray &data,
+					   const hmac_key &key,
+					   char *digest) const
+{
+  /*
+  ** The digest must provide SHA_512_OUTPUT_LENGTH bytes.
+  */
+
+  sha_512_context context;
+  uchar inner[SHA_512_OUTPUT_LENGTH];
+
+  memcpy(context.state, key.inner, sizeof(context.state));
+  context.buffer_length = 0;
+  context.length = static_cast<quint64> (s_block_length);
+  sha_512_update
+    (context, data.constData(), static_cast<size_t> (data.length()));
+  sha_512_final(context, reinterpret_cast<char *> (inner));
+  memcpy(context.state, key.outer, sizeof(context.state));
+  context.buffer_length = 0;
+  context.length = static_cast<quint64> (s_block_length);
+  sha_512_update
+    (context, reinterpret_cast<const char *> (inner), sizeof(inner));
+  sha_512_final(context, digest);
+}
+
+QString spot_on_lite_daemon_sha::sha_512_kernel(void) const
+{
+#ifdef SPOTON_LITE_DAEMON_SHA_512_LANES
+  return selected_sha_512_kernel().description +
+    ", " +
+    selected_sha_512_lanes().description;
+#else
+  return selected_sha_512_kernel().description;
+#endif
+}
+
+void spot_on_lite_daemon_sha::sha_512_final(sha_512_context &context,
+					    char *digest) const
+{
+  /*
+  ** Padding (5.1.2) the buffered bytes. The digest must provide
+  ** SHA_512_OUTPUT_LENGTH bytes.
+  */
+
+  auto blocks = selected_sha_512_kernel().blocks;
+  auto i = context.buffer_length;
+
+  context.buffer[i++] = 0x80;
+
+  if(i > 112)
+    {
+      memset(context.buffer + i, 0, static_cast<size_t> (128 - i));
+      blocks(context.state, context.buffer, 1);
+      i = 0;
+    }
+
+  memset(context.buffer + i, 0, static_cast<size_t> (120 - i));
+  qToBigEndian(8 * context.length, context.buffer + 120);
+  blocks(context.state, context.buffer, 1);
+
+  for(int j = 0; j < 8; j++)
+    qToBigEndian(context.state[j], reinterpret_cast<uchar *> (digest + 8 * j));
+
+  context.buffer_length = 0;
+}
+
+void spot_on_lite_daemon_sha::sha_512_init(sha_512_context &context) const
+{
+  /*
+  ** Initializing H (5.3.5).
+  */
+
+  context.buffer_length = 0;
+  context.length = 0;
+  memcpy(context.state, s_sha_512_h, sizeof(context.state));
+}
+
+void spot_on_lite_daemon_sha::sha_512_update(sha_512_context &context,
+					     const char *data,
+					     const size_t length) const
+{
+  /*
+  ** Complete blocks are compressed in place. Only a partial block is
+  ** buffered.
+  */
+
+  auto blocks = selected_sha_512_kernel().blocks;
+  auto bytes = reinterpret_cast<const uchar *> (data);
+  size_t i = 0;
+
+  context.length += length;
+
+  if(context.buffer_length > 0)
+    {
+      i = qMin(length, static_cast<size_t> (128 - context.buffer_length));
+      memcpy(context.buffer + context.buffer_length, bytes, i);
+      context.buffer_length += static_cast<int> (i);
+
+      if(context.buffer_length < 128)
+	return;
 
-  return sha_512(left.append(sha_512(right.append(data))));
+      blocks(context.state, context.buffer, 1);
+      context.buffer_length = 0;
+    }
+
+  blocks(context.state, bytes + i, (length - i) / 128);
+  i += 128 * ((length - i) / 128);
+
+  if(length > i)
+    {
+      memcpy(context.buffer, bytes + i, length - i);
+      context.buffer_length = static_cast<int> (length - i);
+    }
 }
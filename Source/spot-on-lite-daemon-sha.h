@@ -29,16 +29,53 @@
 #define _spot_on_lite_daemon_sha_h_
 
 #include <QByteArray>
+#include <QString>
 
 class spot_on_lite_daemon_sha
 {
  public:
+  /*
+  ** The SHA-512 states after the padded key has been absorbed with
+  ** the inner and outer pads.
+  */
+
+  struct hmac_key
+  {
+    quint64 inner[8];
+    quint64 outer[8];
+  };
+
+  /*
+  ** A streaming hash. The context is allocated by the caller.
+  */
+
+  struct sha_512_context
+  {
+    int buffer_length;
+    quint64 length; // Bytes.
+    quint64 state[8];
+    uchar buffer[128];
+  };
+
+  static const int SHA_512_OUTPUT_LENGTH = 64;
   spot_on_lite_daemon_sha(void);
+  static quint64 digest_difference(const char *a, const char *b);
   QByteArray sha_512(const QByteArray &data) const;
   QByteArray sha_512_hmac(const QByteArray &data, const QByteArray &key) const;
-
- private:
-  mutable QVector<quint64> m_K;
+  QString sha_512_kernel(void) const;
+  hmac_key prepare_hmac_key(const QByteArray &key) const;
+  void sha_512_final(sha_512_context &context, char *digest) const;
+  void sha_512_hmac(const QByteArray &data,
+		    const hmac_key &key,
+		    char *digest) const;
+  void sha_512_hmac(const QByteArray &data,
+		    const hmac_key *keys,
+		    const int count,
+		    char *digests) const;
+  void sha_512_init(sha_512_context &context) const;
+  void sha_512_update(sha_512_context &context,
+		      const char *data,
+		      const size_t length) const;
 };
 
 #endif
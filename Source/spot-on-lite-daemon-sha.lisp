@@ -180,6 +180,11 @@
 )
 
 (defun sha_512 (data)
+  ;; The data is a simple (unsigned-byte 8) vector. The daemon copies
+  ;; its message into the vector.
+
+  (declare (type (simple-array (unsigned-byte 8) (*)) data))
+
   ;; Initializations.
 
   (let* ((HH (make-array 8
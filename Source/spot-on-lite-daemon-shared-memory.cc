@@ -0,0 +1,189 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+extern "C"
+{
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+#include <QFile>
+
+#include "spot-on-lite-daemon-shared-memory.h"
+
+spot_on_lite_daemon_shared_memory::spot_on_lite_daemon_shared_memory(void)
+{
+  m_data = nullptr;
+  m_inode = 0;
+  m_read_only = false;
+  m_size = 0;
+}
+
+spot_on_lite_daemon_shared_memory::~spot_on_lite_daemon_shared_memory()
+{
+  detach();
+}
+
+bool spot_on_lite_daemon_shared_memory::attach
+(const QString &file_name, const bool read_only)
+{
+  detach();
+
+  auto fd = ::open(QFile::encodeName(file_name).constData(),
+		   read_only ? O_RDONLY : O_RDWR);
+
+  if(fd == -1)
+    return false;
+
+  struct stat st = {};
+
+  if(fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+      ::close(fd);
+      return false;
+    }
+
+  auto data = mmap(nullptr,
+		   static_cast<size_t> (st.st_size),
+		   read_only ? PROT_READ : PROT_READ | PROT_WRITE,
+		   MAP_SHARED,
+		   fd,
+		   0);
+
+  ::close(fd);
+
+  if(data == MAP_FAILED)
+    return false;
+
+  m_data = data;
+  m_file_name = file_name;
+  m_inode = static_cast<quint64> (st.st_ino);
+  m_read_only = read_only;
+  m_size = static_cast<size_t> (st.st_size);
+  return true;
+}
+
+bool spot_on_lite_daemon_shared_memory::create
+(const QString &file_name, const size_t size)
+{
+  detach();
+
+  if(size == 0)
+    return false;
+
+  /*
+  ** Processes which are attached to a previous instance retain
+  ** their mappings.
+  */
+
+  QFile::remove(file_name);
+
+  auto fd = ::open(QFile::encodeName(file_name).constData(),
+		   O_CREAT | O_EXCL | O_RDWR,
+		   S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if(fd == -1)
+    return false;
+
+  struct stat st = {};
+
+  if(ftruncate(fd, static_cast<off_t> (size)) != 0 || fstat(fd, &st) != 0)
+    {
+      ::close(fd);
+      QFile::remove(file_name);
+      return false;
+    }
+
+  auto data = mmap
+    (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  ::close(fd);
+
+  if(data == MAP_FAILED)
+    {
+      QFile::remove(file_name);
+      return false;
+    }
+
+  m_data = data;
+  m_file_name = file_name;
+  m_inode = static_cast<quint64> (st.st_ino);
+  m_read_only = false;
+  m_size = size;
+  return true;
+}
+
+bool spot_on_lite_daemon_shared_memory::is_attached(void) const
+{
+  return m_data != nullptr;
+}
+
+bool spot_on_lite_daemon_shared_memory::is_read_only(void) const
+{
+  return m_read_only;
+}
+
+bool spot_on_lite_daemon_shared_memory::is_stale(void) const
+{
+  if(!m_data)
+    return true;
+
+  /*
+  ** The owner may have removed or replaced the file.
+  */
+
+  struct stat st = {};
+
+  if(stat(QFile::encodeName(m_file_name).constData(), &st) != 0)
+    return true;
+
+  return m_inode != static_cast<quint64> (st.st_ino);
+}
+
+size_t spot_on_lite_daemon_shared_memory::size(void) const
+{
+  return m_size;
+}
+
+void *spot_on_lite_daemon_shared_memory::data(void) const
+{
+  return m_data;
+}
+
+void spot_on_lite_daemon_shared_memory::detach(void)
+{
+  if(m_data)
+    munmap(m_data, m_size);
+
+  m_data = nullptr;
+  m_file_name.clear();
+  m_inode = 0;
+  m_read_only = false;
+  m_size = 0;
+}
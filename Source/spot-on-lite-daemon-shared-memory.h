@@ -0,0 +1,59 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _spot_on_lite_daemon_shared_memory_h_
+#define _spot_on_lite_daemon_shared_memory_h_
+
+#include <QString>
+
+class spot_on_lite_daemon_shared_memory
+{
+ public:
+  spot_on_lite_daemon_shared_memory(void);
+  ~spot_on_lite_daemon_shared_memory();
+  bool attach(const QString &file_name, const bool read_only);
+  bool create(const QString &file_name, const size_t size);
+  bool is_attached(void) const;
+  bool is_read_only(void) const;
+  bool is_stale(void) const;
+  size_t size(void) const;
+  void *data(void) const;
+  void detach(void);
+
+ private:
+  QString m_file_name;
+  bool m_read_only;
+  quint64 m_inode;
+  size_t m_size;
+  void *m_data;
+  spot_on_lite_daemon_shared_memory
+    (const spot_on_lite_daemon_shared_memory &other);
+  spot_on_lite_daemon_shared_memory &operator=
+    (const spot_on_lite_daemon_shared_memory &other);
+};
+
+#endif
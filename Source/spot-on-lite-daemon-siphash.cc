@@ -0,0 +1,137 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+extern "C"
+{
+#include <string.h>
+}
+
+#include <QtEndian>
+
+#include "spot-on-lite-daemon-siphash.h"
+
+/*
+** SipHash-2-4 with a 128-bit output, after the reference
+** implementation of Aumasson and Bernstein.
+*/
+
+static inline quint64 rotl(const quint64 x, const int b)
+{
+  return (x << b) | (x >> (64 - b));
+}
+
+static inline quint64 read_64(const char *bytes)
+{
+  quint64 value = 0;
+
+  memcpy(&value, bytes, sizeof(value));
+  return qFromLittleEndian(value);
+}
+
+static inline void sipround(quint64 &v0, quint64 &v1, quint64 &v2, quint64 &v3)
+{
+  v0 += v1;
+  v1 = rotl(v1, 13);
+  v1 ^= v0;
+  v0 = rotl(v0, 32);
+  v2 += v3;
+  v3 = rotl(v3, 16);
+  v3 ^= v2;
+  v0 += v3;
+  v3 = rotl(v3, 21);
+  v3 ^= v0;
+  v2 += v1;
+  v1 = rotl(v1, 17);
+  v1 ^= v2;
+  v2 = rotl(v2, 32);
+}
+
+static inline void write_64(char *bytes, const quint64 value)
+{
+  auto v = qToLittleEndian(value);
+
+  memcpy(bytes, &v, sizeof(v));
+}
+
+QByteArray spot_on_lite_daemon_siphash::siphash_2_4_128
+(const QByteArray &key, const QByteArray &data)
+{
+  if(key.length() != KEY_SIZE)
+    return QByteArray();
+
+  QByteArray digest(16, 0);
+
+  siphash_2_4_128(key.constData(),
+		  data.constData(),
+		  static_cast<size_t> (data.length()),
+		  digest.data());
+  return digest;
+}
+
+void spot_on_lite_daemon_siphash::siphash_2_4_128
+(const char *key, const char *data, const size_t length, char *digest)
+{
+  auto end = data + (length - length % 8);
+  auto k0 = read_64(key);
+  auto k1 = read_64(key + 8);
+  quint64 v0 = Q_UINT64_C(0x736f6d6570736575) ^ k0;
+  quint64 v1 = Q_UINT64_C(0x646f72616e646f6d) ^ k1 ^ 0xee;
+  quint64 v2 = Q_UINT64_C(0x6c7967656e657261) ^ k0;
+  quint64 v3 = Q_UINT64_C(0x7465646279746573) ^ k1;
+
+  for(auto p = data; p != end; p += 8)
+    {
+      auto m = read_64(p);
+
+      v3 ^= m;
+      sipround(v0, v1, v2, v3);
+      sipround(v0, v1, v2, v3);
+      v0 ^= m;
+    }
+
+  auto b = static_cast<quint64> (length) << 56;
+
+  for(size_t i = 0; i < length % 8; i++)
+    b |= static_cast<quint64> (static_cast<quint8> (end[i])) << (8 * i);
+
+  v3 ^= b;
+  sipround(v0, v1, v2, v3);
+  sipround(v0, v1, v2, v3);
+  v0 ^= b;
+  v2 ^= 0xee;
+
+  for(int i = 0; i < 4; i++)
+    sipround(v0, v1, v2, v3);
+
+  write_64(digest, v0 ^ v1 ^ v2 ^ v3);
+  v1 ^= 0xdd;
+
+  for(int i = 0; i < 4; i++)
+    sipround(v0, v1, v2, v3);
+
+  write_64(digest + 8, v0 ^ v1 ^ v2 ^ v3);
+}
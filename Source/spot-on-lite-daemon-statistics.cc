@@ -0,0 +1,543 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+extern "C"
+{
+#include <errno.h>
+#include <signal.h>
+}
+
+#include <QAtomicInteger>
+#include <QDir>
+
+#include "spot-on-lite-daemon-statistics.h"
+
+/*
+** The segment is a header followed by fixed-size slots. Each slot
+** belongs to a single process and occupies its own cache lines. A
+** writer bumps the sequence of its slot. Readers never lock or write.
+** Each reader remembers the sequences which it has seen.
+*/
+
+struct spot_on_lite_daemon_statistics_header
+{
+  quint64 magic;
+  quint32 slot_count;
+  quint32 version;
+  char reserved[48];
+};
+
+struct alignas(64) spot_on_lite_daemon_statistics_slot
+{
+  QBasicAtomicInteger<qint64> pid;
+  QBasicAtomicInteger<quint64> revision; // Database fields.
+  QBasicAtomicInteger<quint64> sequence;
+  QBasicAtomicInteger<quint64>
+    counters[spot_on_lite_daemon_statistics::MAXIMUM_COUNTERS];
+};
+
+static_assert(sizeof(spot_on_lite_daemon_statistics_header) == 64,
+	      "Irregular statistics header.");
+static_assert(sizeof(spot_on_lite_daemon_statistics_slot) == 512,
+	      "Irregular statistics slot.");
+static_assert(spot_on_lite_daemon_statistics::ZZZ <=
+	      spot_on_lite_daemon_statistics::MAXIMUM_COUNTERS,
+	      "Too many statistics counters.");
+
+static quint64 s_magic = 0x53504f544c495445ULL; // SPOTLITE
+static quint32 s_version = 3;
+
+static spot_on_lite_daemon_statistics_slot *slot_at
+(const spot_on_lite_daemon_shared_memory &shared_memory, const int slot)
+{
+  return reinterpret_cast<spot_on_lite_daemon_statistics_slot *>
+    (static_cast<char *> (shared_memory.data()) +
+     sizeof(spot_on_lite_daemon_statistics_header)) + slot;
+}
+
+spot_on_lite_daemon_statistics::spot_on_lite_daemon_statistics(void)
+{
+  m_owner = false;
+  m_slot = -1;
+}
+
+spot_on_lite_daemon_statistics::~spot_on_lite_daemon_statistics()
+{
+  detach();
+}
+
+QString spot_on_lite_daemon_statistics::counter_name(const Counters counter)
+{
+  switch(counter)
+    {
+    case BYTES_ACCUMULATED:
+      {
+	return "bytes_accumulated";
+      }
+    case BYTES_DROPPED:
+      {
+	return "bytes_dropped";
+      }
+    case BYTES_READ:
+      {
+	return "bytes_read";
+      }
+    case BYTES_WRITTEN:
+      {
+	return "bytes_written";
+      }
+    case CONGESTION_CONTROL_DUPLICATES:
+      {
+	return "congestion_control_duplicates";
+      }
+    case CONGESTION_CONTROL_FILTER_HITS:
+      {
+	return "congestion_control_filter_hits";
+      }
+    case CONGESTION_CONTROL_FILTER_MISSES:
+      {
+	return "congestion_control_filter_misses";
+      }
+    case HUB_BYTES_DROPPED:
+      {
+	return "hub_bytes_dropped";
+      }
+    case HUB_DUPLICATES:
+      {
+	return "hub_duplicates";
+      }
+    case IDENTITY_EVICTIONS:
+      {
+	return "identity_evictions";
+      }
+    case IDENTITY_HMACS:
+      {
+	return "identity_hmacs";
+      }
+    case IDENTITY_MATCHES:
+      {
+	return "identity_matches";
+      }
+    case IDENTITY_RANK_P50:
+      {
+	return "identity_rank_p50";
+      }
+    case IDENTITY_RANK_P99:
+      {
+	return "identity_rank_p99";
+      }
+    case IDENTITY_RANK_P999:
+      {
+	return "identity_rank_p999";
+      }
+    case IDENTITY_SHARES_SUPPRESSED:
+      {
+	return "identity_shares_suppressed";
+      }
+    case LATENCY_LOCAL_IDENTITY_P50:
+      {
+	return "latency_local_identity_p50";
+      }
+    case LATENCY_LOCAL_IDENTITY_P99:
+      {
+	return "latency_local_identity_p99";
+      }
+    case LATENCY_LOCAL_IDENTITY_P999:
+      {
+	return "latency_local_identity_p999";
+      }
+    case LATENCY_LOCAL_PARSE_P50:
+      {
+	return "latency_local_parse_p50";
+      }
+    case LATENCY_LOCAL_PARSE_P99:
+      {
+	return "latency_local_parse_p99";
+      }
+    case LATENCY_LOCAL_PARSE_P999:
+      {
+	return "latency_local_parse_p999";
+      }
+    case LATENCY_LOCAL_TOTAL_P50:
+      {
+	return "latency_local_total_p50";
+      }
+    case LATENCY_LOCAL_TOTAL_P99:
+      {
+	return "latency_local_total_p99";
+      }
+    case LATENCY_LOCAL_TOTAL_P999:
+      {
+	return "latency_local_total_p999";
+      }
+    case LATENCY_LOCAL_WRITE_P50:
+      {
+	return "latency_local_write_p50";
+      }
+    case LATENCY_LOCAL_WRITE_P99:
+      {
+	return "latency_local_write_p99";
+      }
+    case LATENCY_LOCAL_WRITE_P999:
+      {
+	return "latency_local_write_p999";
+      }
+    case LATENCY_REMOTE_CONGESTION_P50:
+      {
+	return "latency_remote_congestion_p50";
+      }
+    case LATENCY_REMOTE_CONGESTION_P99:
+      {
+	return "latency_remote_congestion_p99";
+      }
+    case LATENCY_REMOTE_CONGESTION_P999:
+      {
+	return "latency_remote_congestion_p999";
+      }
+    case LATENCY_REMOTE_PARSE_P50:
+      {
+	return "latency_remote_parse_p50";
+      }
+    case LATENCY_REMOTE_PARSE_P99:
+      {
+	return "latency_remote_parse_p99";
+      }
+    case LATENCY_REMOTE_PARSE_P999:
+      {
+	return "latency_remote_parse_p999";
+      }
+    case LATENCY_REMOTE_TOTAL_P50:
+      {
+	return "latency_remote_total_p50";
+      }
+    case LATENCY_REMOTE_TOTAL_P99:
+      {
+	return "latency_remote_total_p99";
+      }
+    case LATENCY_REMOTE_TOTAL_P999:
+      {
+	return "latency_remote_total_p999";
+      }
+    case LATENCY_REMOTE_WRITE_P50:
+      {
+	return "latency_remote_write_p50";
+      }
+    case LATENCY_REMOTE_WRITE_P99:
+      {
+	return "latency_remote_write_p99";
+      }
+    case LATENCY_REMOTE_WRITE_P999:
+      {
+	return "latency_remote_write_p999";
+      }
+    case LOCAL_QUEUE:
+      {
+	return "local_queue";
+      }
+    case MAXIMUM_ACCUMULATED_BYTES:
+      {
+	return "maximum_accumulated_bytes";
+      }
+    case MEMORY:
+      {
+	return "memory";
+      }
+    case REMOTE_QUEUE:
+      {
+	return "remote_queue";
+      }
+    default:
+      {
+	break;
+      }
+    }
+
+  return "";
+}
+
+QString spot_on_lite_daemon_statistics::file_name(void)
+{
+  return QDir::tempPath() +
+    QDir::separator() +
+    "spot-on-lite-daemon-statistics.shm";
+}
+
+bool spot_on_lite_daemon_statistics::acquire(const qint64 pid)
+{
+  if(!is_attached() || pid <= 0)
+    return false;
+
+  if(m_slot >= 0)
+    return true;
+
+  /*
+  ** Processes which host several children, UDP listeners for example,
+  ** share a single slot. Such children only add to the cumulative
+  ** counters of the slot.
+  */
+
+  for(int i = 0; i < slot_count(); i++)
+    if(slot_at(m_shared_memory, i)->pid.loadAcquire() == pid)
+      {
+	m_owner = false;
+	m_slot = i;
+	return true;
+      }
+
+  for(int i = 0; i < slot_count(); i++)
+    {
+      auto slot = slot_at(m_shared_memory, i);
+      auto p = slot->pid.loadAcquire();
+
+      if(p != 0 &&
+	 !(kill(static_cast<pid_t> (p), 0) == -1 && errno == ESRCH))
+	continue;
+
+      if(slot->pid.testAndSetOrdered(p, pid))
+	{
+	  for(int j = 0; j < MAXIMUM_COUNTERS; j++)
+	    slot->counters[j].storeRelease(0);
+
+	  slot->revision.fetchAndAddOrdered(1);
+	  slot->sequence.fetchAndAddOrdered(1);
+	  m_owner = true;
+	  m_slot = i;
+	  return true;
+	}
+    }
+
+  return false;
+}
+
+bool spot_on_lite_daemon_statistics::attach(const bool read_only)
+{
+  detach();
+
+  if(!m_shared_memory.attach(file_name(), read_only))
+    return false;
+
+  auto header = static_cast<const spot_on_lite_daemon_statistics_header *>
+    (m_shared_memory.data());
+
+  if(m_shared_memory.size() < sizeof(*header) ||
+     header->magic != s_magic ||
+     header->version != s_version ||
+     m_shared_memory.size() < sizeof(*header) +
+     static_cast<size_t> (header->slot_count) *
+     sizeof(spot_on_lite_daemon_statistics_slot))
+    {
+      m_shared_memory.detach();
+      return false;
+    }
+
+  return true;
+}
+
+bool spot_on_lite_daemon_statistics::create(const int count)
+{
+  detach();
+
+  if(count <= 0)
+    return false;
+
+  if(!m_shared_memory.
+     create(file_name(),
+	    sizeof(spot_on_lite_daemon_statistics_header) +
+	    static_cast<size_t> (count) *
+	    sizeof(spot_on_lite_daemon_statistics_slot)))
+    return false;
+
+  /*
+  ** The file is zero-filled.
+  */
+
+  auto header = static_cast<spot_on_lite_daemon_statistics_header *>
+    (m_shared_memory.data());
+
+  header->slot_count = static_cast<quint32> (count);
+  header->version = s_version;
+  header->magic = s_magic;
+  return true;
+}
+
+bool spot_on_lite_daemon_statistics::is_acquired(void) const
+{
+  return m_slot >= 0;
+}
+
+bool spot_on_lite_daemon_statistics::is_attached(void) const
+{
+  return m_shared_memory.is_attached();
+}
+
+bool spot_on_lite_daemon_statistics::is_cumulative(const Counters counter)
+{
+  switch(counter)
+    {
+    case BYTES_DROPPED:
+    case BYTES_READ:
+    case BYTES_WRITTEN:
+    case CONGESTION_CONTROL_DUPLICATES:
+    case CONGESTION_CONTROL_FILTER_HITS:
+    case CONGESTION_CONTROL_FILTER_MISSES:
+    case HUB_BYTES_DROPPED:
+    case HUB_DUPLICATES:
+    case IDENTITY_EVICTIONS:
+    case IDENTITY_HMACS:
+    case IDENTITY_MATCHES:
+    case IDENTITY_SHARES_SUPPRESSED:
+      {
+	return true;
+      }
+    default:
+      {
+	break;
+      }
+    }
+
+  return false;
+}
+
+bool spot_on_lite_daemon_statistics::is_owner(void) const
+{
+  return m_owner;
+}
+
+bool spot_on_lite_daemon_statistics::is_read_only(void) const
+{
+  return m_shared_memory.is_read_only();
+}
+
+bool spot_on_lite_daemon_statistics::is_stale(void) const
+{
+  return m_shared_memory.is_stale();
+}
+
+int spot_on_lite_daemon_statistics::slot_count(void) const
+{
+  if(!is_attached())
+    return 0;
+
+  return static_cast<int>
+    (static_cast<const spot_on_lite_daemon_statistics_header *>
+     (m_shared_memory.data())->slot_count);
+}
+
+qint64 spot_on_lite_daemon_statistics::pid(const int slot) const
+{
+  if(slot < 0 || slot >= slot_count())
+    return 0;
+
+  return slot_at(m_shared_memory, slot)->pid.loadAcquire();
+}
+
+quint64 spot_on_lite_daemon_statistics::revision(const int slot) const
+{
+  if(slot < 0 || slot >= slot_count())
+    return 0;
+
+  return slot_at(m_shared_memory, slot)->revision.loadAcquire();
+}
+
+quint64 spot_on_lite_daemon_statistics::sequence(const int slot) const
+{
+  if(slot < 0 || slot >= slot_count())
+    return 0;
+
+  return slot_at(m_shared_memory, slot)->sequence.loadAcquire();
+}
+
+quint64 spot_on_lite_daemon_statistics::value
+(const int slot, const Counters counter) const
+{
+  if(counter >= ZZZ || slot < 0 || slot >= slot_count())
+    return 0;
+
+  return slot_at(m_shared_memory, slot)->counters[counter].loadAcquire();
+}
+
+void spot_on_lite_daemon_statistics::add
+(const Counters counter, const quint64 value)
+{
+  if(counter >= ZZZ || m_slot < 0)
+    return;
+
+  auto slot = slot_at(m_shared_memory, m_slot);
+
+  slot->counters[counter].fetchAndAddOrdered(value);
+  slot->sequence.fetchAndAddOrdered(1);
+}
+
+void spot_on_lite_daemon_statistics::detach(void)
+{
+  release();
+  m_shared_memory.detach();
+}
+
+void spot_on_lite_daemon_statistics::release(void)
+{
+  if(m_owner && m_slot >= 0)
+    {
+      auto slot = slot_at(m_shared_memory, m_slot);
+
+      slot->sequence.fetchAndAddOrdered(1);
+      slot->pid.storeRelease(0);
+    }
+
+  m_owner = false;
+  m_slot = -1;
+}
+
+void spot_on_lite_daemon_statistics::set
+(const Counters counter, const quint64 value)
+{
+  if(counter >= ZZZ || m_slot < 0)
+    return;
+
+  auto slot = slot_at(m_shared_memory, m_slot);
+
+  if(slot->counters[counter].loadAcquire() == value)
+    return;
+
+  slot->counters[counter].storeRelease(value);
+  slot->sequence.fetchAndAddOrdered(1);
+}
+
+void spot_on_lite_daemon_statistics::touch(void)
+{
+  /*
+  ** The database fields of the process have changed.
+  */
+
+  if(m_slot < 0)
+    return;
+
+  auto slot = slot_at(m_shared_memory, m_slot);
+
+  slot->revision.fetchAndAddOrdered(1);
+  slot->sequence.fetchAndAddOrdered(1);
+}
@@ -0,0 +1,118 @@
+/*
+** Copyright (c) 2011 - 10^10^10, Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from Spot-On-Lite without specific prior written permission.
+**
+** SPOT-ON-LITE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** SPOT-ON-LITE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _spot_on_lite_daemon_statistics_h_
+#define _spot_on_lite_daemon_statistics_h_
+
+#include <QVector>
+
+#include "spot-on-lite-daemon-shared-memory.h"
+
+class spot_on_lite_daemon_statistics
+{
+ public:
+  enum Counters
+    {
+     BYTES_ACCUMULATED = 0,
+     BYTES_DROPPED = 4,
+     BYTES_READ = 1,
+     BYTES_WRITTEN = 2,
+     CONGESTION_CONTROL_DUPLICATES = 33,
+     CONGESTION_CONTROL_FILTER_HITS = 34,
+     CONGESTION_CONTROL_FILTER_MISSES = 35,
+     HUB_BYTES_DROPPED = 5,
+     HUB_DUPLICATES = 36,
+     IDENTITY_EVICTIONS = 43,
+     IDENTITY_HMACS = 38,
+     IDENTITY_MATCHES = 39,
+     IDENTITY_RANK_P50 = 40,
+     IDENTITY_RANK_P99 = 41,
+     IDENTITY_RANK_P999 = 42,
+     IDENTITY_SHARES_SUPPRESSED = 37,
+     LATENCY_LOCAL_IDENTITY_P50 = 9,
+     LATENCY_LOCAL_IDENTITY_P99 = 10,
+     LATENCY_LOCAL_IDENTITY_P999 = 11,
+     LATENCY_LOCAL_PARSE_P50 = 12,
+     LATENCY_LOCAL_PARSE_P99 = 13,
+     LATENCY_LOCAL_PARSE_P999 = 14,
+     LATENCY_LOCAL_TOTAL_P50 = 15,
+     LATENCY_LOCAL_TOTAL_P99 = 16,
+     LATENCY_LOCAL_TOTAL_P999 = 17,
+     LATENCY_LOCAL_WRITE_P50 = 18,
+     LATENCY_LOCAL_WRITE_P99 = 19,
+     LATENCY_LOCAL_WRITE_P999 = 20,
+     LATENCY_REMOTE_CONGESTION_P50 = 21,
+     LATENCY_REMOTE_CONGESTION_P99 = 22,
+     LATENCY_REMOTE_CONGESTION_P999 = 23,
+     LATENCY_REMOTE_PARSE_P50 = 24,
+     LATENCY_REMOTE_PARSE_P99 = 25,
+     LATENCY_REMOTE_PARSE_P999 = 26,
+     LATENCY_REMOTE_TOTAL_P50 = 27,
+     LATENCY_REMOTE_TOTAL_P99 = 28,
+     LATENCY_REMOTE_TOTAL_P999 = 29,
+     LATENCY_REMOTE_WRITE_P50 = 30,
+     LATENCY_REMOTE_WRITE_P99 = 31,
+     LATENCY_REMOTE_WRITE_P999 = 32,
+     LOCAL_QUEUE = 6,
+     MAXIMUM_ACCUMULATED_BYTES = 7,
+     MEMORY = 3,
+     REMOTE_QUEUE = 8,
+     ZZZ = 44
+    };
+
+  static const int MAXIMUM_COUNTERS = 61;
+  spot_on_lite_daemon_statistics(void);
+  ~spot_on_lite_daemon_statistics();
+  static QString counter_name(const Counters counter);
+  static bool is_cumulative(const Counters counter);
+  static QString file_name(void);
+  bool acquire(const qint64 pid);
+  bool attach(const bool read_only);
+  bool create(const int count);
+  bool is_acquired(void) const;
+  bool is_attached(void) const;
+  bool is_owner(void) const;
+  bool is_read_only(void) const;
+  bool is_stale(void) const;
+  int slot_count(void) const;
+  qint64 pid(const int slot) const;
+  quint64 revision(const int slot) const;
+  quint64 sequence(const int slot) const;
+  quint64 value(const int slot, const Counters counter) const;
+  void add(const Counters counter, const quint64 value);
+  void detach(void);
+  void release(void);
+  void set(const Counters counter, const quint64 value);
+  void touch(void);
+
+ private:
+  bool m_owner;
+  int m_slot;
+  spot_on_lite_daemon_shared_memory m_shared_memory;
+};
+
+#endif
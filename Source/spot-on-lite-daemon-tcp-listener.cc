@@ -64,6 +64,11 @@ spot_on_lite_daemon_tcp_listener::
 {
 }
 
+QList<pid_t> spot_on_lite_daemon_tcp_listener::child_pids(void) const
+{
+  return m_child_pids.keys();
+}
+
 void spot_on_lite_daemon_tcp_listener::incomingConnection
 (qintptr socket_descriptor)
 {
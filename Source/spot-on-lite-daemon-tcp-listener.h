@@ -41,6 +41,7 @@ class spot_on_lite_daemon_tcp_listener: public QTcpServer
   spot_on_lite_daemon_tcp_listener(const QString &configuration,
 				   spot_on_lite_daemon *parent);
   ~spot_on_lite_daemon_tcp_listener();
+  QList<pid_t> child_pids(void) const;
 
  protected:
   void incomingConnection(qintptr socket_descriptor);
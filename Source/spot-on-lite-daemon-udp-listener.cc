@@ -62,6 +62,17 @@ spot_on_lite_daemon_udp_listener::~spot_on_lite_daemon_udp_listener()
 {
 }
 
+int spot_on_lite_daemon_udp_listener::clients(void) const
+{
+  int count = 0;
+
+  foreach(const auto &client, m_clients)
+    if(client)
+      count += 1;
+
+  return count;
+}
+
 void spot_on_lite_daemon_udp_listener::new_connection
 (const QByteArray &data,
  const QHostAddress &peer_address,
@@ -43,6 +43,7 @@ class spot_on_lite_daemon_udp_listener: public QUdpSocket
   spot_on_lite_daemon_udp_listener(const QString &configuration,
 				   spot_on_lite_daemon *parent);
   ~spot_on_lite_daemon_udp_listener();
+  int clients(void) const;
 
  private:
   QHash<QString, QPointer<spot_on_lite_daemon_child> > m_clients;
@@ -34,6 +34,7 @@ extern "C"
 #include <unistd.h>
 }
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
 
@@ -43,6 +44,7 @@ extern "C"
 #include <QHostAddress>
 #include <QLocalServer>
 #include <QLocalSocket>
+#include <QSet>
 #include <QSettings>
 #include <QSocketNotifier>
 #include <QSqlDatabase>
@@ -52,6 +54,8 @@ extern "C"
 #include <QtDebug>
 
 #include "spot-on-lite-common.h"
+#include "spot-on-lite-daemon-database.h"
+#include "spot-on-lite-daemon-sha.h"
 #include "spot-on-lite-daemon-tcp-listener.h"
 #include "spot-on-lite-daemon-udp-listener.h"
 #include "spot-on-lite-daemon.h"
@@ -65,6 +69,7 @@ extern "C"
 }
 
 int spot_on_lite_daemon::s_signal_fd[2];
+static int STATISTICS_SLOTS = 4096;
 
 spot_on_lite_daemon::spot_on_lite_daemon
 (const QString &configuration_file_name):QObject()
@@ -74,9 +79,16 @@ spot_on_lite_daemon::spot_on_lite_daemon
 	   "socketpair() failure. Exiting.");
 
   m_configuration_file_name = configuration_file_name;
+  m_congestion_control_capacity = 1048576; // 8 MiB
+  m_congestion_control_digest =
+    spot_on_lite_daemon_congestion_control::SIPHASH_2_4_128;
+  m_congestion_control_filter_false_positive_rate = 0.01;
+  m_congestion_control_filter_memory = 0; // Disabled.
   m_congestion_control_lifetime = 90; // Seconds
-  m_congestion_control_timer.start(15000); // 15 Seconds
+  m_congestion_control_timer.start(1000); // 1 Second
   m_general_timer.start(1500);
+  m_hub_deduplication = false;
+  m_identities_capacity = 65536; // 8 MiB
   m_local_so_rcvbuf_so_sndbuf = 32768; // 32 KiB
   m_local_socket_server_directory_name = QDir::tempPath();
   m_maximum_accumulated_bytes = 8 * 1024 * 1024; // 8 MiB
@@ -86,6 +98,16 @@ spot_on_lite_daemon::spot_on_lite_daemon
   m_statistics_file_name = QDir::tempPath() +
     QDir::separator() +
     "spot-on-lite-daemon-statistics.sqlite";
+  m_statistics_snapshot_interval = 15; // Seconds
+
+  if(m_statistics.create(STATISTICS_SLOTS))
+    m_statistics.acquire(QCoreApplication::applicationPid());
+  else
+    std::cerr << "spot_on_lite_daemon::spot_on_lite_daemon(): "
+	      << "cannot create the statistics segment. "
+	      << "Statistics will be recorded in a database."
+	      << std::endl;
+
   connect(&m_congestion_control_timer,
 	  SIGNAL(timeout(void)),
 	  this,
@@ -98,6 +120,10 @@ spot_on_lite_daemon::spot_on_lite_daemon
 	  SIGNAL(newConnection(void)),
 	  this,
 	  SLOT(slot_new_local_connection(void)));
+  connect(&m_metrics_server,
+	  SIGNAL(newConnection(void)),
+	  this,
+	  SLOT(slot_new_metrics_connection(void)));
   connect(&m_peer_process_timer,
 	  SIGNAL(timeout(void)),
 	  this,
@@ -106,6 +132,10 @@ spot_on_lite_daemon::spot_on_lite_daemon
 	  SIGNAL(timeout(void)),
 	  this,
 	  SLOT(slot_start_timeout(void)));
+  connect(&m_statistics_timer,
+	  SIGNAL(timeout(void)),
+	  this,
+	  SLOT(slot_statistics_timeout(void)));
   connect(m_signal_socket_notifier,
 	  SIGNAL(activated(int)),
 	  this,
@@ -134,15 +164,24 @@ spot_on_lite_daemon::spot_on_lite_daemon
      "daemon",
      QCoreApplication::applicationPid(),
      static_cast<quint64> (1));
+  m_statistics.touch();
 }
 
 spot_on_lite_daemon::spot_on_lite_daemon(void):QObject()
 {
+  m_congestion_control_capacity = 1048576; // 8 MiB
+  m_congestion_control_digest =
+    spot_on_lite_daemon_congestion_control::SIPHASH_2_4_128;
+  m_congestion_control_filter_false_positive_rate = 0.01;
+  m_congestion_control_filter_memory = 0; // Disabled.
   m_congestion_control_lifetime = 90; // Seconds
+  m_hub_deduplication = false;
+  m_identities_capacity = 65536; // 8 MiB
   m_local_so_rcvbuf_so_sndbuf = 0;
   m_local_socket_server_directory_name = QDir::tempPath();
   m_maximum_accumulated_bytes = 0;
   m_signal_socket_notifier = nullptr;
+  m_statistics_snapshot_interval = 0;
 }
 
 spot_on_lite_daemon::~spot_on_lite_daemon()
@@ -157,11 +196,41 @@ spot_on_lite_daemon::~spot_on_lite_daemon()
     QFile::remove(m_statistics_file_name);
 
   QLocalServer::removeServer(m_local_server.fullServerName());
+  QLocalServer::removeServer(m_metrics_server.fullServerName());
   m_congestion_control_future.cancel();
   m_congestion_control_future.waitForFinished();
   m_congestion_control_timer.stop();
+
+  if(m_congestion_control.is_attached())
+    {
+      m_congestion_control.detach();
+      QFile::remove
+	(spot_on_lite_daemon_congestion_control::
+	 file_name(m_congestion_control_file_name));
+    }
+
+  m_identities_future.cancel();
+  m_identities_future.waitForFinished();
+
+  if(m_identities.is_attached())
+    {
+      m_identities.detach();
+      QFile::remove
+	(spot_on_lite_daemon_identities::
+	 file_name(m_remote_identities_file_name));
+    }
+
   m_peer_process_timer.stop();
   m_start_timer.stop();
+  m_statistics_future.cancel();
+  m_statistics_future.waitForFinished();
+  m_statistics_timer.stop();
+
+  if(m_statistics.is_attached())
+    {
+      m_statistics.detach();
+      QFile::remove(spot_on_lite_daemon_statistics::file_name());
+    }
 }
 
 QString spot_on_lite_daemon::certificates_file_name(void) const
@@ -209,6 +278,292 @@ int spot_on_lite_daemon::maximum_accumulated_bytes(void) const
   return m_maximum_accumulated_bytes;
 }
 
+QByteArray spot_on_lite_daemon::deduplicate
+(QLocalSocket *socket, const QByteArray &data)
+{
+  /*
+  ** Complete messages are recorded in the congestion control table
+  ** once, on behalf of all children. Partial messages remain with
+  ** their socket. Identities are shared periodically and are always
+  ** relayed.
+  */
+
+  if(!m_local_sockets.contains(socket))
+    return QByteArray();
+
+  QByteArray unique;
+  auto &content = m_local_sockets[socket];
+  auto marker_length = m_hub_end_of_message_marker.length();
+  int index = 0;
+  quint64 duplicates = 0;
+
+  content.append(data);
+
+  while((index = content.indexOf(m_hub_end_of_message_marker)) >= 0)
+    {
+      auto message(content.mid(0, index + marker_length));
+
+      content.remove(0, message.length());
+
+      if(message.contains("type=" + m_type_identity + "&content=") ||
+	 m_congestion_control.insert(m_congestion_control.digest(message)))
+	unique.append(message);
+      else
+	duplicates += 1;
+    }
+
+  if(content.length() >= m_maximum_accumulated_bytes)
+    {
+      m_statistics.add(spot_on_lite_daemon_statistics::HUB_BYTES_DROPPED,
+		       static_cast<quint64> (content.length()));
+      content.clear();
+    }
+
+  if(duplicates > 0)
+    m_statistics.add
+      (spot_on_lite_daemon_statistics::HUB_DUPLICATES, duplicates);
+
+  return unique;
+}
+
+QByteArray spot_on_lite_daemon::metrics(void)
+{
+  /*
+  ** Prometheus text format. The counters are read from the statistics
+  ** segment. Children are not disturbed. Only current values are
+  ** exported so that every scraper sees the same text. Rates are left
+  ** to rate().
+  */
+
+  struct
+  {
+    spot_on_lite_daemon_statistics::Counters counter;
+    const char *help;
+    const char *name;
+    const char *type;
+  } families[] =
+      {
+       {spot_on_lite_daemon_statistics::BYTES_ACCUMULATED,
+	"Bytes awaiting an end-of-message marker.",
+	"spot_on_lite_process_buffer_bytes",
+	"gauge"},
+       {spot_on_lite_daemon_statistics::MAXIMUM_ACCUMULATED_BYTES,
+	"Capacity of a buffer.",
+	"spot_on_lite_process_buffer_capacity_bytes",
+	"gauge"},
+       {spot_on_lite_daemon_statistics::BYTES_DROPPED,
+	"Bytes discarded because of full buffers or queues.",
+	"spot_on_lite_process_bytes_dropped_total",
+	"counter"},
+       {spot_on_lite_daemon_statistics::BYTES_READ,
+	"Bytes read.",
+	"spot_on_lite_process_bytes_read_total",
+	"counter"},
+       {spot_on_lite_daemon_statistics::BYTES_WRITTEN,
+	"Bytes written.",
+	"spot_on_lite_process_bytes_written_total",
+	"counter"},
+       {spot_on_lite_daemon_statistics::CONGESTION_CONTROL_DUPLICATES,
+	"Messages discarded as duplicates.",
+	"spot_on_lite_process_congestion_control_duplicates_total",
+	"counter"},
+       {spot_on_lite_daemon_statistics::CONGESTION_CONTROL_FILTER_HITS,
+	"Messages which the congestion control filter may have seen.",
+	"spot_on_lite_process_congestion_control_filter_hits_total",
+	"counter"},
+       {spot_on_lite_daemon_statistics::CONGESTION_CONTROL_FILTER_MISSES,
+	"Messages which the congestion control filter ruled out.",
+	"spot_on_lite_process_congestion_control_filter_misses_total",
+	"counter"},
+       {spot_on_lite_daemon_statistics::IDENTITY_EVICTIONS,
+	"Identities evicted from a full identities container.",
+	"spot_on_lite_process_identity_evictions_total",
+	"counter"},
+       {spot_on_lite_daemon_statistics::IDENTITY_HMACS,
+	"HMACs evaluated while matching messages against identities.",
+	"spot_on_lite_process_identity_hmacs_total",
+	"counter"},
+       {spot_on_lite_daemon_statistics::IDENTITY_MATCHES,
+	"Messages which matched an identity.",
+	"spot_on_lite_process_identity_matches_total",
+	"counter"},
+       {spot_on_lite_daemon_statistics::IDENTITY_SHARES_SUPPRESSED,
+	"Identities which were not shared with other children.",
+	"spot_on_lite_process_identity_shares_suppressed_total",
+	"counter"},
+       {spot_on_lite_daemon_statistics::LOCAL_QUEUE,
+	"Bytes queued for the local socket.",
+	"spot_on_lite_process_local_queue_bytes",
+	"gauge"},
+       {spot_on_lite_daemon_statistics::MEMORY,
+	"Maximum resident set size.",
+	"spot_on_lite_process_memory_kilobytes",
+	"gauge"},
+       {spot_on_lite_daemon_statistics::REMOTE_QUEUE,
+	"Bytes queued in the kernel for the remote peer.",
+	"spot_on_lite_process_remote_queue_bytes",
+	"gauge"}
+      };
+  const char *quantiles[] = {"0.5", "0.99", "0.999"};
+  const char *stages[] = {"local_identity",
+			  "local_parse",
+			  "local_total",
+			  "local_write",
+			  "remote_congestion",
+			  "remote_parse",
+			  "remote_total",
+			  "remote_write"};
+  QByteArray text;
+  QHash<qint64, QString> listener_names;
+  QHash<qint64, int> pid_to_slot;
+  QList<qint64> pids;
+
+  foreach(auto listener, m_listeners)
+    {
+      auto tcp_listener = qobject_cast<spot_on_lite_daemon_tcp_listener *>
+	(listener);
+
+      if(tcp_listener)
+	foreach(auto pid, tcp_listener->child_pids())
+	  listener_names[pid] = QString("%1:%2").
+	    arg(tcp_listener->serverAddress().toString()).
+	    arg(tcp_listener->serverPort());
+    }
+
+  for(int i = 0; i < m_statistics.slot_count(); i++)
+    {
+      auto pid = m_statistics.pid(i);
+
+      if(pid > 0 && kill(static_cast<pid_t> (pid), 0) == 0)
+	{
+	  pid_to_slot[pid] = i;
+	  pids << pid;
+	}
+    }
+
+  std::sort(pids.begin(), pids.end());
+
+  for(size_t i = 0; i < sizeof(families) / sizeof(families[0]); i++)
+    {
+      text.append(QString("# HELP %1 %2\n# TYPE %1 %3\n").
+		  arg(families[i].name).
+		  arg(families[i].help).
+		  arg(families[i].type).toUtf8());
+
+      foreach(auto pid, pids)
+	text.append
+	  (QString("%1{listener=\"%2\",pid=\"%3\"} %4\n").
+	   arg(families[i].name).
+	   arg(listener_names.value(pid)).
+	   arg(pid).
+	   arg(m_statistics.value(pid_to_slot.value(pid),
+				  families[i].counter)).toUtf8());
+    }
+
+  text.append("# HELP spot_on_lite_process_latency_nanoseconds "
+	      "Message forwarding latency percentiles over the last "
+	      "publication window.\n"
+	      "# TYPE spot_on_lite_process_latency_nanoseconds gauge\n");
+
+  foreach(auto pid, pids)
+    for(size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++)
+      for(size_t j = 0; j < sizeof(quantiles) / sizeof(quantiles[0]); j++)
+	{
+	  auto counter = static_cast<spot_on_lite_daemon_statistics::Counters>
+	    (spot_on_lite_daemon_statistics::LATENCY_LOCAL_IDENTITY_P50 +
+	     i * sizeof(quantiles) / sizeof(quantiles[0]) + j);
+
+	  text.append
+	    (QString("spot_on_lite_process_latency_nanoseconds"
+		     "{listener=\"%1\",pid=\"%2\",quantile=\"%3\","
+		     "stage=\"%4\"} %5\n").
+	     arg(listener_names.value(pid)).
+	     arg(pid).
+	     arg(quantiles[j]).
+	     arg(stages[i]).
+	     arg(m_statistics.value(pid_to_slot.value(pid), counter)).
+	     toUtf8());
+	}
+
+  text.append("# HELP spot_on_lite_process_identity_rank "
+	      "Positions of matched identities in the search order over "
+	      "the last publication window.\n"
+	      "# TYPE spot_on_lite_process_identity_rank gauge\n");
+
+  foreach(auto pid, pids)
+    for(size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++)
+      text.append
+	(QString("spot_on_lite_process_identity_rank"
+		 "{listener=\"%1\",pid=\"%2\",quantile=\"%3\"} %4\n").
+	 arg(listener_names.value(pid)).
+	 arg(pid).
+	 arg(quantiles[i]).
+	 arg(m_statistics.
+	     value(pid_to_slot.value(pid),
+		   static_cast<spot_on_lite_daemon_statistics::Counters>
+		   (spot_on_lite_daemon_statistics::IDENTITY_RANK_P50 + i))).
+	 toUtf8());
+
+  text.append("# HELP spot_on_lite_listener_processes "
+	      "Processes or clients of a listener.\n"
+	      "# TYPE spot_on_lite_listener_processes gauge\n");
+
+  foreach(auto listener, m_listeners)
+    {
+      auto tcp_listener = qobject_cast<spot_on_lite_daemon_tcp_listener *>
+	(listener);
+      auto udp_listener = qobject_cast<spot_on_lite_daemon_udp_listener *>
+	(listener);
+
+      if(tcp_listener)
+	text.append
+	  (QString("spot_on_lite_listener_processes"
+		   "{listener=\"%1:%2\",protocol=\"tcp\"} %3\n").
+	   arg(tcp_listener->serverAddress().toString()).
+	   arg(tcp_listener->serverPort()).
+	   arg(tcp_listener->child_pids().size()).toUtf8());
+      else if(udp_listener)
+	text.append
+	  (QString("spot_on_lite_listener_processes"
+		   "{listener=\"%1:%2\",protocol=\"udp\"} %3\n").
+	   arg(udp_listener->localAddress().toString()).
+	   arg(udp_listener->localPort()).
+	   arg(udp_listener->clients()).toUtf8());
+    }
+
+  qint64 hub_queue = 0;
+
+  foreach(auto socket, m_local_sockets.keys())
+    if(socket)
+      hub_queue += socket->bytesToWrite();
+
+  text.append
+    (QString("# HELP spot_on_lite_hub_bytes_dropped_total "
+	     "Bytes which the daemon could not relay.\n"
+	     "# TYPE spot_on_lite_hub_bytes_dropped_total counter\n"
+	     "spot_on_lite_hub_bytes_dropped_total %1\n"
+	     "# HELP spot_on_lite_hub_duplicates_total "
+	     "Messages which the daemon discarded as duplicates.\n"
+	     "# TYPE spot_on_lite_hub_duplicates_total counter\n"
+	     "spot_on_lite_hub_duplicates_total %4\n"
+	     "# HELP spot_on_lite_hub_queue_bytes "
+	     "Bytes queued for local sockets.\n"
+	     "# TYPE spot_on_lite_hub_queue_bytes gauge\n"
+	     "spot_on_lite_hub_queue_bytes %2\n"
+	     "# HELP spot_on_lite_hub_sockets Local sockets.\n"
+	     "# TYPE spot_on_lite_hub_sockets gauge\n"
+	     "spot_on_lite_hub_sockets %3\n").
+     arg(m_statistics.
+	 value(pid_to_slot.value(QCoreApplication::applicationPid(), -1),
+	       spot_on_lite_daemon_statistics::HUB_BYTES_DROPPED)).
+     arg(hub_queue).
+     arg(m_local_sockets.size()).
+     arg(m_statistics.
+	 value(pid_to_slot.value(QCoreApplication::applicationPid(), -1),
+	       spot_on_lite_daemon_statistics::HUB_DUPLICATES)).toUtf8());
+  return text;
+}
+
 size_t spot_on_lite_daemon::memory(void) const
 {
   struct rusage rusage = {};
@@ -240,6 +595,117 @@ void spot_on_lite_daemon::log(const QString &error) const
     }
 }
 
+void spot_on_lite_daemon::prepare_congestion_control(void)
+{
+  /*
+  ** The children attach to the table when they are created. Previous
+  ** children have been terminated.
+  */
+
+  m_congestion_control_future.cancel();
+  m_congestion_control_future.waitForFinished();
+
+  if(m_congestion_control.is_attached())
+    m_congestion_control.detach();
+
+  m_hub_end_of_message_marker.clear();
+
+  if(m_congestion_control_file_name.isEmpty())
+    return;
+
+  if(!m_congestion_control.
+     create(spot_on_lite_daemon_congestion_control::
+	    file_name(m_congestion_control_file_name),
+	    m_congestion_control_capacity,
+	    m_congestion_control_lifetime.fetchAndAddAcquire(0),
+	    m_congestion_control_filter_memory,
+	    m_congestion_control_filter_false_positive_rate,
+	    m_congestion_control_digest))
+    {
+      std::cerr << "spot_on_lite_daemon::prepare_congestion_control(): "
+		<< "cannot create the congestion control table. "
+		<< "Congestion control will be recorded in a database."
+		<< std::endl;
+      return;
+    }
+
+  if(!m_hub_deduplication)
+    return;
+
+  /*
+  ** The daemon separates the messages of every local socket with the
+  ** end-of-message marker of the listeners and peers.
+  */
+
+  QSet<QString> markers;
+
+  foreach(const auto &properties,
+	  m_listeners_properties + m_peers_properties)
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+    markers << properties.split(",", Qt::KeepEmptyParts).value(7);
+#else
+    markers << properties.split(",", QString::KeepEmptyParts).value(7);
+#endif
+
+  if(markers.size() == 1 && !markers.begin()->isEmpty())
+    {
+      m_congestion_control.set_hub_deduplication(true);
+      m_hub_end_of_message_marker = markers.begin()->toUtf8();
+    }
+  else
+    std::cerr << "spot_on_lite_daemon::prepare_congestion_control(): "
+	      << "hub deduplication requires a common "
+	      << "end-of-message marker. Children will examine messages."
+	      << std::endl;
+}
+
+void spot_on_lite_daemon::prepare_identities(void)
+{
+  /*
+  ** The children attach to the registry when they are created. Entries
+  ** expire after the longest identities lifetime of the listeners and
+  ** peers. Identities are shared again after half of the shortest
+  ** lifetime so that no child's peers forget them.
+  */
+
+  m_identities_future.cancel();
+  m_identities_future.waitForFinished();
+
+  if(m_identities.is_attached())
+    m_identities.detach();
+
+  if(m_remote_identities_file_name.isEmpty())
+    return;
+
+  auto lifetime = 30;
+  auto shortest_lifetime = 600;
+
+  foreach(const auto &properties,
+	  m_listeners_properties + m_peers_properties)
+    {
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+      auto value = properties.split(",", Qt::KeepEmptyParts).value(9).toInt();
+#else
+      auto value = properties.split(",", QString::KeepEmptyParts).
+	value(9).toInt();
+#endif
+
+      lifetime = qMax(lifetime, value);
+      shortest_lifetime = qMin(shortest_lifetime, qBound(5, value, 600));
+    }
+
+  if(!m_identities.
+     create(spot_on_lite_daemon_identities::
+	    file_name(m_remote_identities_file_name),
+	    m_identities_capacity,
+	    lifetime,
+	    shortest_lifetime / 2))
+    std::cerr << "spot_on_lite_daemon::prepare_identities(): "
+	      << "cannot create the identities registry. "
+	      << "Children will share every identity."
+	      << std::endl;
+}
+
 void spot_on_lite_daemon::prepare_listeners(void)
 {
   while(!m_listeners.isEmpty())
@@ -288,6 +754,20 @@ void spot_on_lite_daemon::prepare_local_socket_server(void)
     m_local_sockets.clear();
 }
 
+void spot_on_lite_daemon::prepare_metrics_server(void)
+{
+  auto name(QString("%1/Spot-On-Lite-Daemon-Metrics.%2").
+	    arg(m_local_socket_server_directory_name).
+	    arg(QCoreApplication::applicationPid()));
+
+  if(QFileInfo(name).exists() && m_metrics_server.isListening())
+    return;
+
+  m_metrics_server.close();
+  QLocalServer::removeServer(name);
+  m_metrics_server.listen(name);
+}
+
 void spot_on_lite_daemon::prepare_peers(void)
 {
   for(int i = 0; i < m_peers_properties.size(); i++)
@@ -429,6 +909,60 @@ void spot_on_lite_daemon::process_configuration_file(bool *ok)
     else if(key == "child_process_ld_library_path")
       m_child_process_ld_library_path =
 	settings.value(key).toString().trimmed();
+    else if(key == "congestion_control_capacity")
+      {
+	auto congestion_control_capacity = settings.value(key).toInt(&o);
+
+	if(congestion_control_capacity <
+	   spot_on_lite_daemon_congestion_control::MINIMUM_CAPACITY ||
+	   congestion_control_capacity >
+	   spot_on_lite_daemon_congestion_control::MAXIMUM_CAPACITY ||
+	   !o)
+	  {
+	    if(ok)
+	      *ok = false;
+
+	    std::cerr << "spot_on_lite_daemon::"
+		      << "process_configuration_file(): The "
+		      << "congestion_control_capacity value \""
+		      << settings.value(key).toString().toStdString()
+		      << "\" is invalid. "
+		      << "Expecting a value "
+		      << "in the range ["
+		      << spot_on_lite_daemon_congestion_control::MINIMUM_CAPACITY
+		      << ", "
+		      << spot_on_lite_daemon_congestion_control::MAXIMUM_CAPACITY
+		      << "]. Ignoring entry."
+		      << std::endl;
+	  }
+	else
+	  m_congestion_control_capacity = congestion_control_capacity;
+      }
+    else if(key == "congestion_control_digest")
+      {
+	auto digest = settings.value(key).toString().trimmed().toLower();
+
+	if(digest == "sha3-384")
+	  m_congestion_control_digest =
+	    spot_on_lite_daemon_congestion_control::SHA3_384;
+	else if(digest == "siphash-2-4-128")
+	  m_congestion_control_digest =
+	    spot_on_lite_daemon_congestion_control::SIPHASH_2_4_128;
+	else
+	  {
+	    if(ok)
+	      *ok = false;
+
+	    std::cerr << "spot_on_lite_daemon::"
+		      << "process_configuration_file(): The "
+		      << "congestion_control_digest value \""
+		      << settings.value(key).toString().toStdString()
+		      << "\" is invalid. "
+		      << "Expecting sha3-384 or siphash-2-4-128. "
+		      << "Ignoring entry."
+		      << std::endl;
+	  }
+      }
     else if(key == "congestion_control_file")
       {
 #ifdef Q_OS_WINDOWS
@@ -460,6 +994,55 @@ void spot_on_lite_daemon::process_configuration_file(bool *ok)
 		      << std::endl;
 	  }
       }
+    else if(key == "congestion_control_filter_false_positive_rate")
+      {
+	auto rate = settings.value(key).toDouble(&o);
+
+	if(!o || rate <= 0.0 || rate >= 1.0)
+	  {
+	    if(ok)
+	      *ok = false;
+
+	    std::cerr << "spot_on_lite_daemon::"
+		      << "process_configuration_file(): The "
+		      << "congestion_control_filter_false_positive_rate "
+		      << "value \""
+		      << settings.value(key).toString().toStdString()
+		      << "\" is invalid. "
+		      << "Expecting a value "
+		      << "in the range (0, 1). Ignoring entry."
+		      << std::endl;
+	  }
+	else
+	  m_congestion_control_filter_false_positive_rate = rate;
+      }
+    else if(key == "congestion_control_filter_memory")
+      {
+	auto memory = settings.value(key).toLongLong(&o);
+
+	if(!o ||
+	   memory < 0 ||
+	   memory > spot_on_lite_daemon_congestion_control::
+	   MAXIMUM_FILTER_MEMORY)
+	  {
+	    if(ok)
+	      *ok = false;
+
+	    std::cerr << "spot_on_lite_daemon::"
+		      << "process_configuration_file(): The "
+		      << "congestion_control_filter_memory value \""
+		      << settings.value(key).toString().toStdString()
+		      << "\" is invalid. "
+		      << "Expecting a value "
+		      << "in the range [0, "
+		      << spot_on_lite_daemon_congestion_control::
+			 MAXIMUM_FILTER_MEMORY
+		      << "]. Ignoring entry."
+		      << std::endl;
+	  }
+	else
+	  m_congestion_control_filter_memory = memory;
+      }
     else if(key == "congestion_control_lifetime")
       {
 	auto congestion_control_lifetime = settings.value(key).toInt(&o);
@@ -484,6 +1067,37 @@ void spot_on_lite_daemon::process_configuration_file(bool *ok)
 	  m_congestion_control_lifetime.fetchAndStoreAcquire
 	    (congestion_control_lifetime);
       }
+    else if(key == "hub_deduplication")
+      m_hub_deduplication = settings.value(key).toBool();
+    else if(key == "identities_capacity")
+      {
+	auto identities_capacity = settings.value(key).toInt(&o);
+
+	if(identities_capacity <
+	   spot_on_lite_daemon_identities::MINIMUM_CAPACITY ||
+	   identities_capacity >
+	   spot_on_lite_daemon_identities::MAXIMUM_CAPACITY ||
+	   !o)
+	  {
+	    if(ok)
+	      *ok = false;
+
+	    std::cerr << "spot_on_lite_daemon::"
+		      << "process_configuration_file(): The "
+		      << "identities_capacity value \""
+		      << settings.value(key).toString().toStdString()
+		      << "\" is invalid. "
+		      << "Expecting a value "
+		      << "in the range ["
+		      << spot_on_lite_daemon_identities::MINIMUM_CAPACITY
+		      << ", "
+		      << spot_on_lite_daemon_identities::MAXIMUM_CAPACITY
+		      << "]. Ignoring entry."
+		      << std::endl;
+	  }
+	else
+	  m_identities_capacity = identities_capacity;
+      }
     else if(key == "local_so_rcvbuf_so_sndbuf")
       {
 	auto so_rcvbuf_so_sndbuf = settings.value(key).toInt(&o);
@@ -884,10 +1498,55 @@ void spot_on_lite_daemon::process_configuration_file(bool *ok)
 		      << std::endl;
 	  }
       }
+    else if(key == "statistics_snapshot_interval")
+      {
+	auto statistics_snapshot_interval = settings.value(key).toInt(&o);
+
+	if(!o ||
+	   statistics_snapshot_interval < 0 ||
+	   statistics_snapshot_interval > 3600)
+	  {
+	    if(ok)
+	      *ok = false;
+
+	    std::cerr << "spot_on_lite_daemon::"
+		      << "process_configuration_file(): The "
+		      << "statistics_snapshot_interval value \""
+		      << settings.value(key).toString().toStdString()
+		      << "\" is invalid. "
+		      << "Expecting a value "
+		      << "in the range [0, 3600]. Ignoring entry."
+		      << std::endl;
+	  }
+	else
+	  m_statistics_snapshot_interval = statistics_snapshot_interval;
+      }
+    else if(key == "type_identity")
+      m_type_identity = settings.value(key).toByteArray();
 }
 
 void spot_on_lite_daemon::purge_congestion_control(void)
 {
+  if(m_congestion_control.is_attached())
+    {
+      m_congestion_control.set_lifetime
+	(m_congestion_control_lifetime.fetchAndAddAcquire(0));
+      m_congestion_control.purge();
+      m_congestion_control.rotate();
+    }
+
+  /*
+  ** Children record congestion in the database if they cannot attach
+  ** to the table. The purge is performed every second and the
+  ** insertion dates are indexed, so each purge removes the entries of
+  ** the expired second.
+  */
+
+  QFileInfo file_info(m_congestion_control_file_name);
+
+  if(!file_info.exists() || file_info.size() == 0)
+    return;
+
   {
     auto db = QSqlDatabase::addDatabase
       ("QSQLITE", "congestion_control_database");
@@ -900,11 +1559,15 @@ void spot_on_lite_daemon::purge_congestion_control(void)
 
 	query.exec("PRAGMA journal_mode = OFF");
 	query.exec("PRAGMA synchronous = OFF");
-	query.exec
-	  (QString("DELETE FROM congestion_control WHERE "
-		   "%1 - date_time_inserted > %2").
-	   arg(QDateTime::currentDateTime().toTime_t()).
-	   arg(m_congestion_control_lifetime.fetchAndAddAcquire(0)));
+	query.exec("CREATE INDEX IF NOT EXISTS "
+		   "congestion_control_date_time_inserted "
+		   "ON congestion_control (date_time_inserted)");
+	query.prepare("DELETE FROM congestion_control WHERE "
+		      "date_time_inserted < ?");
+	query.addBindValue
+	  (static_cast<qint64> (QDateTime::currentDateTime().toTime_t()) -
+	   m_congestion_control_lifetime.fetchAndAddAcquire(0));
+	query.exec();
       }
 
     db.close();
@@ -913,8 +1576,83 @@ void spot_on_lite_daemon::purge_congestion_control(void)
   QSqlDatabase::removeDatabase("congestion_control_database");
 }
 
+void spot_on_lite_daemon::purge_identities(void)
+{
+  m_identities.purge();
+}
+
+void spot_on_lite_daemon::save_statistics_snapshot(void)
+{
+  /*
+  ** Copy the counters of the statistics segment into the statistics
+  ** database for external consumers.
+  */
+
+  {
+    auto db = QSqlDatabase::addDatabase("QSQLITE", "statistics_database");
+
+    db.setDatabaseName(m_statistics_file_name);
+
+    if(db.open())
+      {
+	QList<spot_on_lite_daemon_statistics::Counters> counters;
+	QSqlQuery query(db);
+
+	counters << spot_on_lite_daemon_statistics::BYTES_ACCUMULATED
+		 << spot_on_lite_daemon_statistics::BYTES_READ
+		 << spot_on_lite_daemon_statistics::BYTES_WRITTEN
+		 << spot_on_lite_daemon_statistics::MEMORY;
+	query.exec("PRAGMA journal_mode = OFF");
+	query.exec("PRAGMA synchronous = OFF");
+	db.transaction();
+	query.prepare("UPDATE statistics SET "
+		      "bytes_accumulated = ?, "
+		      "bytes_read = ?, "
+		      "bytes_written = ?, "
+		      "memory = ? "
+		      "WHERE pid = ?");
+
+	for(int i = 0; i < m_statistics.slot_count(); i++)
+	  {
+	    if(m_statistics_future.isCanceled())
+	      break;
+
+	    auto pid = m_statistics.pid(i);
+
+	    if(pid <= 0)
+	      continue;
+
+	    for(const auto counter : counters)
+	      query.addBindValue
+		(QString::number(m_statistics.value(i, counter)));
+
+	    query.addBindValue(pid);
+	    query.exec();
+	  }
+
+	db.commit();
+      }
+
+    db.close();
+  }
+
+  QSqlDatabase::removeDatabase("statistics_database");
+}
+
 void spot_on_lite_daemon::slot_general_timeout(void)
 {
+  if(m_identities.is_attached() && m_identities_future.isFinished())
+    m_identities_future = QtConcurrent::run
+      (this, &spot_on_lite_daemon::purge_identities);
+
+  if(m_statistics.is_acquired())
+    {
+      m_statistics.set
+	(spot_on_lite_daemon_statistics::MEMORY,
+	 static_cast<quint64> (memory()));
+      return;
+    }
+
   spot_on_lite_common::save_statistic
     ("memory",
      m_statistics_file_name,
@@ -950,7 +1688,7 @@ void spot_on_lite_daemon::slot_new_local_connection(void)
     (sockfd, SOL_SOCKET, SO_RCVBUF, &m_local_so_rcvbuf_so_sndbuf, optlen);
   setsockopt
     (sockfd, SOL_SOCKET, SO_SNDBUF, &m_local_so_rcvbuf_so_sndbuf, optlen);
-  m_local_sockets[socket] = 0;
+  m_local_sockets[socket] = QByteArray();
   connect(socket,
 	  SIGNAL(disconnected(void)),
 	  this,
@@ -961,6 +1699,21 @@ void spot_on_lite_daemon::slot_new_local_connection(void)
 	  SLOT(slot_ready_read(void)));
 }
 
+void spot_on_lite_daemon::slot_new_metrics_connection(void)
+{
+  auto socket = m_metrics_server.nextPendingConnection();
+
+  if(!socket)
+    return;
+
+  connect(socket,
+	  SIGNAL(disconnected(void)),
+	  socket,
+	  SLOT(deleteLater(void)));
+  socket->write(metrics());
+  socket->disconnectFromServer();
+}
+
 void spot_on_lite_daemon::slot_peer_process_timeout(void)
 {
   prepare_peers();
@@ -985,7 +1738,13 @@ void spot_on_lite_daemon::slot_ready_read(void)
   while(socket->bytesAvailable() > 0)
     data.append(socket->readAll());
 
-  QHashIterator<QLocalSocket *, char> it(m_local_sockets);
+  if(!m_hub_end_of_message_marker.isEmpty())
+    data = deduplicate(socket, data);
+
+  if(data.isEmpty())
+    return;
+
+  QHashIterator<QLocalSocket *, QByteArray> it(m_local_sockets);
 
   while(it.hasNext())
     {
@@ -998,6 +1757,11 @@ void spot_on_lite_daemon::slot_ready_read(void)
 	  auto maximum = m_local_so_rcvbuf_so_sndbuf -
 	    static_cast<int> (it.key()->bytesToWrite());
 
+	  if(maximum < data.length())
+	    m_statistics.add
+	      (spot_on_lite_daemon_statistics::HUB_BYTES_DROPPED,
+	       static_cast<quint64> (data.length() - qMax(0, maximum)));
+
 	  if(maximum > 0)
 	    it.key()->write(data.mid(0, maximum));
 	}
@@ -1048,6 +1812,14 @@ void spot_on_lite_daemon::slot_signal(void)
 void spot_on_lite_daemon::slot_start_timeout(void)
 {
   prepare_local_socket_server();
+  prepare_metrics_server();
+}
+
+void spot_on_lite_daemon::slot_statistics_timeout(void)
+{
+  if(m_statistics_future.isFinished())
+    m_statistics_future = QtConcurrent::run
+      (this, &spot_on_lite_daemon::save_statistics_snapshot);
 }
 
 void spot_on_lite_daemon::start(void)
@@ -1061,8 +1833,25 @@ void spot_on_lite_daemon::start(void)
   m_peer_process_timer.start(2500);
   m_peers_properties.clear();
   process_configuration_file(nullptr);
+
+  /*
+  ** The databases were removed. In-process children must not reuse
+  ** connections to the removed files.
+  */
+
+  spot_on_lite_daemon_database::clear();
+  log(QString("spot_on_lite_daemon::start(): the SHA-512 kernel is %1.").
+      arg(spot_on_lite_daemon_sha().sha_512_kernel()));
+  prepare_congestion_control();
+  prepare_identities();
   prepare_listeners();
   prepare_local_socket_server();
+  prepare_metrics_server();
+
+  if(m_statistics.is_attached() && m_statistics_snapshot_interval > 0)
+    m_statistics_timer.start(1000 * m_statistics_snapshot_interval);
+  else
+    m_statistics_timer.stop();
 }
 
 void spot_on_lite_daemon::validate_configuration_file
@@ -37,6 +37,10 @@
 #include <QTimer>
 #include <QVector>
 
+#include "spot-on-lite-daemon-congestion-control.h"
+#include "spot-on-lite-daemon-identities.h"
+#include "spot-on-lite-daemon-statistics.h"
+
 class QSocketNotifier;
 
 class spot_on_lite_daemon: public QObject
@@ -64,11 +68,16 @@ class spot_on_lite_daemon: public QObject
 
  private:
   QAtomicInt m_congestion_control_lifetime;
+  QByteArray m_hub_end_of_message_marker;
+  QByteArray m_type_identity;
   QFuture<void> m_congestion_control_future;
-  QHash<QLocalSocket *, char> m_local_sockets;
+  QFuture<void> m_identities_future;
+  QFuture<void> m_statistics_future;
+  QHash<QLocalSocket *, QByteArray> m_local_sockets; // Partial messages.
   QHash<int, pid_t> m_peer_pids;
   QList<QObject *> m_listeners;
   QLocalServer m_local_server;
+  QLocalServer m_metrics_server;
   QSocketNotifier *m_signal_socket_notifier;
   QString m_certificates_file_name;
   QString m_child_process_file_name;
@@ -83,27 +92,48 @@ class spot_on_lite_daemon: public QObject
   QTimer m_general_timer;
   QTimer m_peer_process_timer;
   QTimer m_start_timer;
+  QTimer m_statistics_timer;
   QVector<QString> m_listeners_properties;
   QVector<QString> m_peers_properties;
+  bool m_hub_deduplication;
+  double m_congestion_control_filter_false_positive_rate;
+  int m_congestion_control_capacity;
+  int m_identities_capacity;
   int m_local_so_rcvbuf_so_sndbuf;
   int m_maximum_accumulated_bytes;
+  int m_statistics_snapshot_interval;
+  qint64 m_congestion_control_filter_memory;
+  spot_on_lite_daemon_congestion_control m_congestion_control;
+  spot_on_lite_daemon_congestion_control::Digests
+    m_congestion_control_digest;
+  spot_on_lite_daemon_identities m_identities;
+  spot_on_lite_daemon_statistics m_statistics;
   static int s_signal_fd[2];
+  QByteArray deduplicate(QLocalSocket *socket, const QByteArray &data);
+  QByteArray metrics(void);
   size_t memory(void) const;
+  void prepare_congestion_control(void);
+  void prepare_identities(void);
   void prepare_listeners(void);
   void prepare_local_socket_server(void);
+  void prepare_metrics_server(void);
   void prepare_peers(void);
   void process_configuration_file(bool *ok);
   void purge_congestion_control(void);
+  void purge_identities(void);
+  void save_statistics_snapshot(void);
 
  private slots:
   void slot_general_timeout(void);
   void slot_local_socket_disconnected(void);
   void slot_new_local_connection(void);
+  void slot_new_metrics_connection(void);
   void slot_peer_process_timeout(void);
   void slot_purge_congestion_control_timeout(void);
   void slot_ready_read(void);
   void slot_signal(void);
   void slot_start_timeout(void);
+  void slot_statistics_timeout(void);
 
  signals:
   void child_died(const pid_t pid);
@@ -39,6 +39,7 @@ extern "C"
 }
 #endif
 
+#include "spot-on-lite-daemon-statistics.h"
 #include "spot-on-lite-monitor.h"
 
 static spot_on_lite_monitor::Columns field_name_to_column
@@ -221,13 +222,156 @@ QString spot_on_lite_monitor::ini_path(void)
     "Spot-On-Lite-Monitor.INI";
 }
 
+void spot_on_lite_monitor::poll_statistics_database
+(QMap<qint64, QMap<Columns, QString> > &processes)
+{
+  /*
+  ** Read every row. The statistics segment is not available.
+  */
+
+  const QString db_connection_id("1");
+
+  {
+    auto db = QSqlDatabase::addDatabase("QSQLITE", db_connection_id);
+
+    db.setDatabaseName(statistics_database_path());
+
+    if(db.open())
+      {
+	QSqlQuery query(db);
+	auto deleted_processes(processes.keys());
+
+	query.setForwardOnly(true);
+
+	if(query.exec("SELECT arguments, "  // 0
+		      "bytes_accumulated, " // 1
+		      "bytes_read, "        // 2
+		      "bytes_written, "     // 3
+		      "ip_information, "    // 4
+		      "memory, "            // 5
+		      "name, "              // 6
+		      "pid, "               // 7
+		      "type "               // 8
+		      "FROM statistics"))
+	  while(query.next())
+	    {
+	      QMap<Columns, QString> values;
+
+	      values[ARGUMENTS] = query.value(0).toString();
+	      values[BYTES_ACCUMULATED] = query.value(1).toString();
+	      values[BYTES_READ] = query.value(2).toString();
+	      values[BYTES_WRITTEN] = query.value(3).toString();
+	      values[IP_INFORMATION] = query.value(4).toString();
+	      values[MEMORY] = query.value(5).toString();
+	      values[NAME] = query.value(6).toString();
+	      values[PID] = query.value(7).toString();
+	      values[TYPE] = query.value(8).toString();
+
+	      auto pid = values.value(PID).toLongLong();
+
+	      values[STATUS] = status(pid);
+
+	      auto index = deleted_processes.indexOf(pid);
+
+	      if(index >= 0)
+		deleted_processes.removeAt(index);
+
+	      publish(processes, values);
+	    }
+
+	for(auto pid : deleted_processes)
+	  {
+	    emit deleted(pid);
+	    processes.remove(pid);
+	  }
+      }
+
+    db.close();
+  }
+
+  QSqlDatabase::removeDatabase(db_connection_id);
+}
+
+QString spot_on_lite_monitor::statistics_database_path(void)
+{
+  return QDir::tempPath() +
+    QDir::separator() +
+    "spot-on-lite-daemon-statistics.sqlite";
+}
+
+QString spot_on_lite_monitor::status(const qint64 pid) const
+{
+#ifdef Q_OS_UNIX
+  if(kill(static_cast<pid_t> (pid), 0) != 0)
+    return tr("Dead");
+#else
+  Q_UNUSED(pid);
+#endif
+
+  return tr("Active");
+}
+
+QString spot_on_lite_monitor::tool_tip
+(const QMap<Columns, QString> &values) const
+{
+  return tr
+    ("<html>"
+     "<b>Name:</b> %1<br>"
+     "<b>PID:</b> %2<br>"
+     "<b>Status:</b> %3<br>"
+     "<b>IP Information:</b> %4<br>"
+     "<b>Memory:</b> %5<br>"
+     "<b>Bytes Accumulated:</b> %6<br>"
+     "<b>Bytes Read:</b> %7<br>"
+     "<b>Bytes Written:</b> %8<br>"
+     "<b>Type:</b> %9<br>"
+     "<b>Arguments:</b> %10"
+     "</html>").
+    arg(values.value(NAME)).
+    arg(values.value(PID)).
+    arg(values.value(STATUS)).
+    arg(values.value(IP_INFORMATION)).
+    arg(values.value(MEMORY)).
+    arg(values.value(BYTES_ACCUMULATED)).
+    arg(values.value(BYTES_READ)).
+    arg(values.value(BYTES_WRITTEN)).
+    arg(values.value(TYPE)).
+    arg(values.value(ARGUMENTS));
+}
+
+void spot_on_lite_monitor::publish
+(QMap<qint64, QMap<Columns, QString> > &processes,
+ const QMap<Columns, QString> &values)
+{
+  auto pid = values.value(PID).toLongLong();
+
+  if(!processes.contains(pid))
+    {
+      if(!values.value(ARGUMENTS).isEmpty() &&
+	 !values.value(NAME).isEmpty() &&
+	 !values.value(TYPE).isEmpty())
+	{
+	  processes[pid] = values;
+	  emit added(values, tool_tip(values));
+	}
+    }
+  else if(processes.value(pid) != values)
+    {
+      emit changed(values, tool_tip(values));
+      processes[pid] = values;
+    }
+}
+
 void spot_on_lite_monitor::read_statistics_database(void)
 {
+  QHash<int, qint64> slot_to_pid;
   QMap<qint64, QMap<Columns, QString> > processes;
+  QVector<quint64> revisions;
+  QVector<quint64> sequences;
+  auto all = true;
   const QString db_connection_id("1");
-  const auto db_path(QDir::tempPath() +
-		     QDir::separator() +
-		     "spot-on-lite-daemon-statistics.sqlite");
+  spot_on_lite_daemon_statistics statistics;
+  unsigned int ticks = 0;
 
   while(true)
     {
@@ -235,117 +379,187 @@ void spot_on_lite_monitor::read_statistics_database(void)
 	break;
 
       QThread::msleep(100);
+      ticks += 1;
 
-      if(!QFileInfo(db_path).isReadable())
+      if(!QFileInfo(statistics_database_path()).isReadable() ||
+	 (statistics.is_attached() && statistics.is_stale()))
 	{
 	  for(auto pid : processes.keys())
 	    emit deleted(pid);
 
+	  processes.clear();
+	  slot_to_pid.clear();
+	  statistics.detach();
 	  continue;
 	}
 
-      {
-	auto db = QSqlDatabase::addDatabase("QSQLITE", db_connection_id);
+      if(!statistics.is_attached())
+	{
+	  /*
+	  ** The monitor only reads the segment. It compares the
+	  ** sequences of the slots with those which it has seen so that
+	  ** other readers are not disturbed.
+	  */
+
+	  if(statistics.attach(true))
+	    {
+	      for(auto pid : processes.keys())
+		emit deleted(pid);
+
+	      all = true;
+	      processes.clear();
+	      revisions.fill(0, statistics.slot_count());
+	      sequences.fill(0, statistics.slot_count());
+	      slot_to_pid.clear();
+	    }
+	  else
+	    {
+	      poll_statistics_database(processes);
+	      continue;
+	    }
+	}
+
+      /*
+      ** Only the slots which have changed are visited. The database
+      ** is queried for processes whose database fields have changed.
+      */
+
+      QList<int> changed;
+      QList<qint64> queries;
+
+      for(int i = 0; i < statistics.slot_count(); i++)
+	if(all ||
+	   sequences.at(i) != statistics.sequence(i) ||
+	   slot_to_pid.value(i) != statistics.pid(i))
+	  changed << i;
+
+      all = false;
+
+      if(ticks % 10 == 0)
+	{
+	  /*
+	  ** Processes which have terminated abnormally do not release
+	  ** their slots.
+	  */
+
+	  QHashIterator<int, qint64> it(slot_to_pid);
+
+	  while(it.hasNext())
+	    {
+	      it.next();
+
+	      if(!changed.contains(it.key()) &&
+		 processes.value(it.value()).value(STATUS) !=
+		 status(it.value()))
+		changed << it.key();
+	    }
+	}
+
+      for(int i = changed.size() - 1; i >= 0; i--)
+	{
+	  auto slot = changed.at(i);
+	  auto pid = statistics.pid(slot);
+	  auto previous_pid = slot_to_pid.value(slot);
+
+	  sequences[slot] = statistics.sequence(slot);
+
+	  if(previous_pid > 0 && previous_pid != pid)
+	    {
+	      emit deleted(previous_pid);
+	      processes.remove(previous_pid);
+	      revisions[slot] = 0;
+	      slot_to_pid.remove(slot);
+	    }
+
+	  if(pid <= 0)
+	    {
+	      changed.removeAt(i);
+	      continue;
+	    }
+
+	  slot_to_pid[slot] = pid;
+
+	  if(!processes.contains(pid) ||
+	     revisions.at(slot) != statistics.revision(slot))
+	    queries << pid;
+	}
+
+      if(changed.isEmpty())
+	continue;
 
-	db.setDatabaseName(db_path);
+      QHash<qint64, QMap<Columns, QString> > rows;
 
-	if(db.open())
+      if(!queries.isEmpty())
+	{
 	  {
-	    QSqlQuery query(db);
-	    QString tool_tip("");
-	    auto deleted_processes(processes.keys());
-
-	    query.setForwardOnly(true);
-
-	    if(query.exec("SELECT arguments, "  // 0
-			  "bytes_accumulated, " // 1
-			  "bytes_read, "        // 2
-			  "bytes_written, "     // 3
-			  "ip_information, "    // 4
-			  "memory, "            // 5
-			  "name, "              // 6
-			  "pid, "               // 7
-			  "type "               // 8
-			  "FROM statistics"))
-	      while(query.next())
-		{
-		  QMap<Columns, QString> values;
-		  QString status(tr("Active"));
+	    auto db = QSqlDatabase::addDatabase("QSQLITE", db_connection_id);
 
-		  values[ARGUMENTS] = query.value(0).toString();
-		  values[BYTES_ACCUMULATED] = query.value(1).toString();
-		  values[BYTES_READ] = query.value(2).toString();
-		  values[BYTES_WRITTEN] = query.value(3).toString();
-		  values[IP_INFORMATION] = query.value(4).toString();
-		  values[MEMORY] = query.value(5).toString();
-		  values[NAME] = query.value(6).toString();
-		  values[PID] = query.value(7).toString();
-		  values[TYPE] = query.value(8).toString();
+	    db.setDatabaseName(statistics_database_path());
 
-		  auto pid = values.value(PID).toLongLong();
+	    if(db.open())
+	      {
+		QSqlQuery query(db);
 
-#ifdef Q_OS_UNIX
-		  if(kill(static_cast<pid_t> (pid), 0) != 0)
-		    status = tr("Dead");
-#else
-#endif
+		query.prepare("SELECT arguments, " // 0
+			      "ip_information, "   // 1
+			      "name, "             // 2
+			      "type "              // 3
+			      "FROM statistics WHERE pid = ?");
 
-		  values[STATUS] = status;
-
-		  auto index = deleted_processes.indexOf(pid);
-
-		  if(index >= 0)
-		    deleted_processes.removeAt(index);
-
-		  tool_tip = tr
-		    ("<html>"
-		     "<b>Name:</b> %1<br>"
-		     "<b>PID:</b> %2<br>"
-		     "<b>Status:</b> %3<br>"
-		     "<b>IP Information:</b> %4<br>"
-		     "<b>Memory:</b> %5<br>"
-		     "<b>Bytes Accumulated:</b> %6<br>"
-		     "<b>Bytes Read:</b> %7<br>"
-		     "<b>Bytes Written:</b> %8<br>"
-		     "<b>Type:</b> %9<br>"
-		     "<b>Arguments:</b> %10"
-		     "</html>").
-		    arg(values.value(NAME)).
-		    arg(values.value(PID)).
-		    arg(values.value(STATUS)).
-		    arg(values.value(IP_INFORMATION)).
-		    arg(values.value(MEMORY)).
-		    arg(values.value(BYTES_ACCUMULATED)).
-		    arg(values.value(BYTES_READ)).
-		    arg(values.value(BYTES_WRITTEN)).
-		    arg(values.value(TYPE)).
-		    arg(values.value(ARGUMENTS));
-
-		  if(!processes.contains(pid))
-		    {
-		      if(!values.value(ARGUMENTS).isEmpty() &&
-			 !values.value(NAME).isEmpty() &&
-			 !values.value(TYPE).isEmpty())
-			{
-			  processes[pid] = values;
-			  emit added(values, tool_tip);
-			}
-		    }
-		  else if(processes.value(pid) != values)
-		    {
-		      emit changed(values, tool_tip);
-		      processes[pid] = values;
-		    }
-		}
+		for(auto pid : queries)
+		  {
+		    query.addBindValue(pid);
+
+		    if(query.exec() && query.next())
+		      {
+			rows[pid][ARGUMENTS] = query.value(0).toString();
+			rows[pid][IP_INFORMATION] = query.value(1).toString();
+			rows[pid][NAME] = query.value(2).toString();
+			rows[pid][TYPE] = query.value(3).toString();
+		      }
 
-	    for(auto pid : deleted_processes)
-	      emit deleted(pid);
+		    query.finish();
+		  }
+	      }
+
+	    db.close();
 	  }
 
-	db.close();
-      }
+	  QSqlDatabase::removeDatabase(db_connection_id);
+	}
+
+      for(auto slot : changed)
+	{
+	  auto pid = slot_to_pid.value(slot);
+	  auto values(processes.value(pid));
+
+	  if(rows.contains(pid))
+	    {
+	      QMapIterator<Columns, QString> it(rows.value(pid));
 
-      QSqlDatabase::removeDatabase(db_connection_id);
+	      while(it.hasNext())
+		{
+		  it.next();
+		  values[it.key()] = it.value();
+		}
+
+	      revisions[slot] = statistics.revision(slot);
+	    }
+
+	  values[BYTES_ACCUMULATED] = QString::number
+	    (statistics.
+	     value(slot, spot_on_lite_daemon_statistics::BYTES_ACCUMULATED));
+	  values[BYTES_READ] = QString::number
+	    (statistics.value(slot, spot_on_lite_daemon_statistics::BYTES_READ));
+	  values[BYTES_WRITTEN] = QString::number
+	    (statistics.
+	     value(slot, spot_on_lite_daemon_statistics::BYTES_WRITTEN));
+	  values[MEMORY] = QString::number
+	    (statistics.value(slot, spot_on_lite_daemon_statistics::MEMORY));
+	  values[PID] = QString::number(pid);
+	  values[STATUS] = status(pid);
+	  publish(processes, values);
+	}
     }
 }
 
@@ -87,8 +87,15 @@ class spot_on_lite_monitor: public QMainWindow
   QTimer m_path_timer;
   Ui_spot_on_lite_monitor m_ui;
   pid_t m_daemon_pid;
+  QString status(const qint64 pid) const;
+  QString tool_tip(const QMap<Columns, QString> &values) const;
   static QString home_path(void);
   static QString ini_path(void);
+  static QString statistics_database_path(void);
+  void poll_statistics_database
+    (QMap<qint64, QMap<Columns, QString> > &processes);
+  void publish(QMap<qint64, QMap<Columns, QString> > &processes,
+	       const QMap<Columns, QString> &values);
   void read_statistics_database(void);
 
  private slots:
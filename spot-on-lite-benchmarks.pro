@@ -0,0 +1,11 @@
+include (common.pro)
+
+HEADERS = Source/spot-on-lite-daemon-sha.h \
+          Source/spot-on-lite-daemon-siphash.h
+RESOURCES =
+SOURCES = Source/spot-on-lite-benchmarks.cc \
+          Source/spot-on-lite-daemon-sha.cc \
+          Source/spot-on-lite-daemon-siphash.cc
+
+PROJECTNAME = Spot-On-Lite-Benchmarks
+TARGET = Spot-On-Lite-Benchmarks
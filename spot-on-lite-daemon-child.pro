@@ -1,10 +1,26 @@
 include (common.pro)
 
-HEADERS = Source/spot-on-lite-daemon-child.h
+HEADERS = Source/spot-on-lite-daemon-child.h \
+          Source/spot-on-lite-daemon-congestion-control.h \
+          Source/spot-on-lite-daemon-database.h \
+          Source/spot-on-lite-daemon-histogram.h \
+          Source/spot-on-lite-daemon-identities.h \
+          Source/spot-on-lite-daemon-identities-container.h \
+          Source/spot-on-lite-daemon-shared-memory.h \
+          Source/spot-on-lite-daemon-siphash.h \
+          Source/spot-on-lite-daemon-statistics.h
 RESOURCES =
 SOURCES = Source/spot-on-lite-daemon-child.cc \
           Source/spot-on-lite-daemon-child-main.cc \
-          Source/spot-on-lite-daemon-sha.cc
+          Source/spot-on-lite-daemon-congestion-control.cc \
+          Source/spot-on-lite-daemon-database.cc \
+          Source/spot-on-lite-daemon-histogram.cc \
+          Source/spot-on-lite-daemon-identities.cc \
+          Source/spot-on-lite-daemon-identities-container.cc \
+          Source/spot-on-lite-daemon-sha.cc \
+          Source/spot-on-lite-daemon-shared-memory.cc \
+          Source/spot-on-lite-daemon-siphash.cc \
+          Source/spot-on-lite-daemon-statistics.cc
 
 PROJECTNAME = Spot-On-Lite-Daemon-Child
 TARGET = Spot-On-Lite-Daemon-Child
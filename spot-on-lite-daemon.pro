@@ -2,13 +2,29 @@ include (common.pro)
 
 HEADERS = Source/spot-on-lite-daemon.h \
           Source/spot-on-lite-daemon-child.h \
+          Source/spot-on-lite-daemon-congestion-control.h \
+          Source/spot-on-lite-daemon-database.h \
+          Source/spot-on-lite-daemon-histogram.h \
+          Source/spot-on-lite-daemon-identities.h \
+          Source/spot-on-lite-daemon-identities-container.h \
+          Source/spot-on-lite-daemon-shared-memory.h \
+          Source/spot-on-lite-daemon-siphash.h \
+          Source/spot-on-lite-daemon-statistics.h \
           Source/spot-on-lite-daemon-tcp-listener.h \
           Source/spot-on-lite-daemon-udp-listener.h
 RESOURCES =
 SOURCES = Source/spot-on-lite-daemon.cc \
           Source/spot-on-lite-daemon-child.cc \
+          Source/spot-on-lite-daemon-congestion-control.cc \
+          Source/spot-on-lite-daemon-database.cc \
+          Source/spot-on-lite-daemon-histogram.cc \
+          Source/spot-on-lite-daemon-identities.cc \
+          Source/spot-on-lite-daemon-identities-container.cc \
           Source/spot-on-lite-daemon-main.cc \
           Source/spot-on-lite-daemon-sha.cc \
+          Source/spot-on-lite-daemon-shared-memory.cc \
+          Source/spot-on-lite-daemon-siphash.cc \
+          Source/spot-on-lite-daemon-statistics.cc \
           Source/spot-on-lite-daemon-tcp-listener.cc \
           Source/spot-on-lite-daemon-udp-listener.cc
 
@@ -8,9 +8,13 @@ QMAKE_DISTCLEAN += .qmake.*
 QT		+= gui sql widgets
 
 FORMS           = UI/spot-on-lite-monitor.ui
-HEADERS		= Source/spot-on-lite-monitor.h
+HEADERS		= Source/spot-on-lite-daemon-shared-memory.h \
+		  Source/spot-on-lite-daemon-statistics.h \
+		  Source/spot-on-lite-monitor.h
 RESOURCES	= Icons/icons.qrc
-SOURCES		= Source/spot-on-lite-monitor.cc
+SOURCES		= Source/spot-on-lite-daemon-shared-memory.cc \
+		  Source/spot-on-lite-daemon-statistics.cc \
+		  Source/spot-on-lite-monitor.cc
 TRANSLATIONS    =
 UI_HEADERS_DIR  = .
 